@@ -107,6 +107,89 @@ LynxVersion::operator uint32_t() const
 	return temp;
 }
 
+void LynxNameIndex::clear()
+{
+	_entries.clear();
+	_buckets.clear();
+}
+
+void LynxNameIndex::insert(uint32_t hash, const LynxId & lynxId)
+{
+	// Keep the load factor below 1
+	if (_entries.count() >= _buckets.count())
+		this->rehash((_buckets.count() < 8) ? 8 : (_buckets.count() * 2));
+
+	int bucket = int(hash & uint32_t(_buckets.count() - 1));
+
+	int entry = _entries.append();
+	_entries[entry].hash = hash;
+	_entries[entry].lynxId = lynxId;
+	_entries[entry].next = -1;
+
+	// Append to the end of the chain, so the first match is always the first one inserted
+	if (_buckets.at(bucket) < 0)
+	{
+		_buckets[bucket] = entry;
+		return;
+	}
+
+	int last = _buckets.at(bucket);
+	while (_entries.at(last).next >= 0)
+	{
+		last = _entries.at(last).next;
+	}
+
+	_entries[last].next = entry;
+}
+
+int LynxNameIndex::first(uint32_t hash) const
+{
+	if (_buckets.count() < 1)
+		return -1;
+
+	int entry = _buckets.at(int(hash & uint32_t(_buckets.count() - 1)));
+
+	while ((entry >= 0) && (_entries.at(entry).hash != hash))
+	{
+		entry = _entries.at(entry).next;
+	}
+
+	return entry;
+}
+
+int LynxNameIndex::next(int entry) const
+{
+	uint32_t hash = _entries.at(entry).hash;
+	entry = _entries.at(entry).next;
+
+	while ((entry >= 0) && (_entries.at(entry).hash != hash))
+	{
+		entry = _entries.at(entry).next;
+	}
+
+	return entry;
+}
+
+void LynxNameIndex::rehash(int bucketCount)
+{
+	// The entries never outnumber the buckets, so this keeps append() from reallocating on every insert
+	_entries.resize(bucketCount);
+	_buckets.reserve(bucketCount);
+
+	for (int i = 0; i < bucketCount; i++)
+	{
+		_buckets.append(-1);
+	}
+
+	// Entries are linked oldest first, so the chains keep the order in which they were inserted
+	for (int i = (_entries.count() - 1); i >= 0; i--)
+	{
+		int bucket = int(_entries.at(i).hash & uint32_t(bucketCount - 1));
+		_entries[i].next = _buckets.at(bucket);
+		_buckets[bucket] = i;
+	}
+}
+
 //-----------------------------------------------------------------------------------------------------------
 //-------------------------------------------- LynxType -----------------------------------------------------
 //-----------------------------------------------------------------------------------------------------------
@@ -126,10 +209,13 @@ LynxType::LynxType()
 			_endianness = LynxLib::eBigEndian;
 	}
 
-	_dataType = LynxLib::eNotInitialized;
 	_var = LYNX_NULL;
+	_ownsValue = false;
+	_bound = false;
 	_str = LYNX_NULL;
-	_description = LYNX_NULL;
+	_array = LYNX_NULL;
+	_info = LYNX_NULL;
+	_ownsInfo = false;
 }
 
 LynxType::LynxType(LynxLib::E_LynxDataType dataType, const LynxString & description) : LynxType()
@@ -137,18 +223,14 @@ LynxType::LynxType(LynxLib::E_LynxDataType dataType, const LynxString & descript
 	this->init(dataType, &description);
 }
 
-LynxType::LynxType(const LynxType & other) : LynxType(other._dataType, *other._description) 
+LynxType::LynxType(const LynxType & other) : LynxType()
 { 
 	*this = other; 
 }
 
 LynxType::~LynxType()
 {
-	if (_var != LYNX_NULL)
-	{
-		delete _var;
-		_var = LYNX_NULL;
-	}
+	this->releaseValue();
 
 	if (_str != LYNX_NULL)
 	{
@@ -156,186 +238,546 @@ LynxType::~LynxType()
 		_str = LYNX_NULL;
 	}
 
-	if (_description != LYNX_NULL)
+	if (_array != LYNX_NULL)
 	{
-		delete _description;
-		_description = LYNX_NULL;
+		delete[] _array;
+		_array = LYNX_NULL;
 	}
+
+	this->shareInfo(LYNX_NULL);
 }
 
-void LynxType::init(LynxLib::E_LynxDataType dataType, const LynxString * const description)
+void LynxType::init(LynxLib::E_LynxDataType dataType, const LynxString * const description, int arrayLength)
 {
-	_dataType = dataType;
-	LynxLib::E_LynxDataType tmpType = LynxLib::E_LynxDataType(dataType & 0x7f);
+	LynxVariableInfo * info = new LynxVariableInfo();
+
+	info->dataType = dataType;
+
+	if (LynxLib::isArray(LynxLib::E_LynxDataType(dataType & 0x7f)) && (arrayLength > 0))
+		info->arrayLength = arrayLength;
+
+	if (description != LYNX_NULL)
+		info->description = *description;
+
+	this->init(info);
+	_ownsInfo = true;
+}
+
+void LynxType::init(LynxVariableInfo * info)
+{
+	this->shareInfo(info);
+
+	if (_array != LYNX_NULL)
+	{
+		delete[] _array;
+		_array = LYNX_NULL;
+	}
+
+	if (info == LYNX_NULL)
+		return;
+
+	LynxLib::E_LynxDataType tmpType = LynxLib::E_LynxDataType(info->dataType & 0x7f);
 
 	if (tmpType > LynxLib::eNotInitialized)
 	{
-		if (tmpType == LynxLib::eString_RW)
+		if (LynxLib::isArray(tmpType))
+		{
+			this->releaseValue();
+
+			if (_str != LYNX_NULL)
+			{
+				delete _str;
+				_str = LYNX_NULL;
+			}
+
+			if (info->arrayLength > 0)
+			{
+				int blocks = (info->arrayLength * LynxLib::localSize(tmpType) + int(sizeof(LynxUnion)) - 1) / int(sizeof(LynxUnion));
+				_array = new LynxUnion[blocks]();
+			}
+		}
+		else if (tmpType == LynxLib::eString_RW)
 		{
+			this->releaseValue();
+
 			if (_str != LYNX_NULL)
 				delete _str;
 			_str = new LynxString("");
 		}
 		else if (tmpType < LynxLib::eLynxType_RW_EndOfList)
 		{
-			if (_var != LYNX_NULL)
-				delete _var;
+			if (_str != LYNX_NULL)
+			{
+				delete _str;
+				_str = LYNX_NULL;
+			}
+
+			this->releaseValue();
 			_var = new LynxUnion();
+			_ownsValue = true;
 		}
 	}
+}
 
-	if (_description != LYNX_NULL)
-		delete _description;
+void LynxType::shareInfo(LynxVariableInfo * info)
+{
+	if ((_info != LYNX_NULL) && _ownsInfo)
+		delete _info;
+
+	_info = info;
+	_ownsInfo = false;
+}
 
-	if (description == LYNX_NULL)
+void LynxType::bindValue(LynxUnion * storage)
+{
+	if (_var == LYNX_NULL)
 		return;
-	if (description->isEmpty())
+
+	*storage = *_var;
+	this->releaseValue();
+	_var = storage;
+}
+
+void LynxType::bindExternal(void * address)
+{
+	if (_var == LYNX_NULL) // Strings and arrays can't be bound
 		return;
 
-	_description = new LynxString(*description);
+	if (address != LYNX_NULL)
+	{
+		this->releaseValue();
+		_var = static_cast<LynxUnion *>(address);
+		_bound = true;
+		return;
+	}
+
+	if (!_bound)
+		return;
+
+	LynxUnion * storage = new LynxUnion();
+	memcpy(storage, _var, this->localSize());
+
+	_var = storage;
+	_ownsValue = true;
+	_bound = false;
+}
+
+void LynxType::releaseValue()
+{
+	if ((_var != LYNX_NULL) && _ownsValue)
+		delete _var;
+
+	_var = LYNX_NULL;
+	_ownsValue = false;
+	_bound = false;
+}
+
+uint64_t LynxType::bits() const
+{
+	if (_var == LYNX_NULL)
+		return 0;
+
+	switch (this->localSize())
+	{
+	case 1:
+		return _var->_var_u8;
+	case 2:
+		return _var->_var_u16;
+	case 4:
+		return _var->_var_u32;
+	case 8:
+		return _var->_var_u64;
+	default:
+		return 0;
+	}
+}
+
+void LynxType::setBits(uint64_t bits)
+{
+	if (_var == LYNX_NULL)
+		return;
+
+	switch (this->localSize())
+	{
+	case 1:
+		_var->_var_u8 = uint8_t(bits);
+		break;
+	case 2:
+		_var->_var_u16 = uint16_t(bits);
+		break;
+	case 4:
+		_var->_var_u32 = uint32_t(bits);
+		break;
+	case 8:
+		_var->_var_u64 = bits;
+		break;
+	default:
+		break;
+	}
+}
+
+// Finite and not NaN
+static bool finiteFloat(float value)
+{
+	return ((value == value) && ((value - value) == 0.0f));
+}
+
+bool LynxType::setScaling(float scale, float offset)
+{
+	if (LynxLib::E_LynxDataType(this->dataType() & 0x7f) != LynxLib::eScaled16_RW)
+		return false;
+
+	if ((scale == 0.0f) || !finiteFloat(scale) || !finiteFloat(offset))
+		return false;
+
+	_info->scale = scale;
+	_info->offset = offset;
+
+	return true;
+}
+
+uint16_t LynxType::encodeConverted() const
+{
+	if (LynxLib::E_LynxDataType(_info->dataType & 0x7f) == LynxLib::eHalf_RW)
+		return LynxLib::floatToHalf(_var->_var_float);
+
+	double raw = (double(_var->_var_float) - _info->offset) / _info->scale;
+
+	if (raw != raw) // NaN
+		return 0;
+
+	// Rounded to the nearest integer, and clamped to the range of int16_t
+	raw = (raw < 0) ? (raw - 0.5) : (raw + 0.5);
+
+	if (raw > 32767.0)
+		raw = 32767.0;
+	else if (raw < -32768.0)
+		raw = -32768.0;
+
+	return uint16_t(int16_t(raw));
+}
+
+float LynxType::decodeConverted(uint16_t raw) const
+{
+	if (LynxLib::E_LynxDataType(_info->dataType & 0x7f) == LynxLib::eHalf_RW)
+		return LynxLib::halfToFloat(raw);
+
+	return float(double(int16_t(raw)) * _info->scale + _info->offset);
 }
 
 LynxString LynxType::description() const
 {
-	if (_description == LYNX_NULL)
+	if ((_info == LYNX_NULL) || _info->description.isEmpty())
 		return "Not defined";
 	else
-		return *_description;
+		return _info->description;
 }
 
 int LynxType::toArray(LynxByteArray & buffer, LynxLib::E_LynxState & state) const
 {
-    int transferSize = this->transferSize();
+	int startIndex = buffer.count();
+	int transferSize = this->toArray(buffer.extend(this->transferSize()), state);
+
+	if (transferSize < 1) // Nothing was written
+		buffer.remove(startIndex, buffer.count() - 1);
+
+	return transferSize;
+}
 
-    LynxByteArray tempBuffer(transferSize);
+int LynxType::toArray(char * buffer, LynxLib::E_LynxState & state) const
+{
+	LynxLib::E_LynxDataType dataType = this->dataType();
 
-	if ((_dataType == LynxLib::eString_RW) || (_dataType == LynxLib::eString_RO))
+	if ((dataType == LynxLib::eString_RW) || (dataType == LynxLib::eString_RO))
 	{
-		tempBuffer.append(char(transferSize - 1));				// Add the size
-		tempBuffer.append(_str->toCharArray(), _str->count());	// Add the string
+		int transferSize = this->transferSize();
+
+		buffer[0] = char(transferSize - 1);			// Add the size
+		for (int i = 1; i < transferSize; i++)		// Add the string
+		{
+			buffer[i] = _str->at(i - 1);
+		}
+
+		return transferSize;
 	}
-	else
+
+	if (LynxLib::isConverted(dataType))
 	{
-		int localSize = this->localSize();
-		if (localSize < 1) // Datatype not recognized
+		uint16_t raw = this->encodeConverted();
+
+		buffer[0] = char(raw & 0xff);
+		buffer[1] = char((raw >> 8) & 0xff);
+
+		return 2;
+	}
+
+	if (_array != LYNX_NULL)
+	{
+		// The elements follow each other without any padding, each one little endian
+		int width = LynxLib::transferSize(dataType);
+		int size = _info->arrayLength * width;
+		const char * elements = reinterpret_cast<const char *>(_array);
+
+		if (_endianness == LynxLib::eLittleEndian)
 		{
-			state = LynxLib::eDataTypeNotFound;
-			return 0;
+			memcpy(buffer, elements, size);
 		}
-
-		switch (LynxType::endianness())
+		else
 		{
-		case LynxLib::eBigEndian:
-			for (int i = 0; i < localSize; i++)
-			{
-				tempBuffer.append(_var->bytes[int(SIZE_64) - i - 1]);
-			}
-			break;
-		case LynxLib::eLittleEndian:
-			for (int i = 0; i < localSize; i++)
+			for (int i = 0; i < size; i += width)
 			{
-				tempBuffer.append(_var->bytes[i]);
+				for (int j = 0; j < width; j++)
+				{
+					buffer[i + j] = elements[i + width - 1 - j];
+				}
 			}
-			break;
-		default:
-			state = LynxLib::eEndiannessNotSet;
-			return 0;
 		}
 
-		LynxLib::splitArray(tempBuffer, transferSize);
+		return size;
+	}
+
+	// The value is always transferred as little endian, regardless of the local endianness
+	uint64_t bits;
+	int transferSize = this->transferSize();
 
-		if (tempBuffer.count() != transferSize)
-		{
-			state = LynxLib::eSplitArrayFailed;
-			return 0;
-		}
+	switch (transferSize)
+	{
+	case 1:
+		bits = _var->_var_u8;
+		break;
+	case 2:
+		bits = _var->_var_u16;
+		break;
+	case 4:
+		bits = _var->_var_u32;
+		break;
+	case 8:
+		bits = _var->_var_u64;
+		break;
+	default: // Datatype not recognized
+		state = LynxLib::eDataTypeNotFound;
+		return 0;
 	}
 
-    buffer.append(tempBuffer);
+	for (int i = 0; i < transferSize; i++)
+	{
+		buffer[i] = char((bits >> (8 * i)) & 0xff);
+	}
 
-    return transferSize;
+	return transferSize;
 }
 
 int LynxType::fromArray(const LynxByteArray & buffer, int startIndex, LynxLib::E_LynxState & state)
-{        	
+{
+	return this->fromArray(buffer.data() + startIndex, buffer.count() - startIndex, state);
+}
+
+int LynxType::fromArray(const char * buffer, int size, LynxLib::E_LynxState & state, bool writeReadOnly, bool * valueChanged)
+{
 	int transferSize;
+	LynxLib::E_LynxDataType dataType = this->dataType();
 
-	if ((_dataType == LynxLib::eString_RW) || (_dataType == LynxLib::eString_RO))
+	if (valueChanged != LYNX_NULL)
+		*valueChanged = false;
+
+	if ((dataType == LynxLib::eString_RW) || (dataType == LynxLib::eString_RO))
 	{
-		transferSize = int(buffer.at(startIndex)); // If it's a string the first byte should specify the size
+		if (size < 1)
+		{
+			state = LynxLib::eWrongDataLength;
+			return 0;
+		}
+
+		transferSize = int(buffer[0]) & 0xff; // If it's a string the first byte should specify the size
 		transferSize++; // Increment transfersize to include the size specifier
 
-		if ((_dataType & 0x80) != 0) // Read only
+		if (transferSize > size)
+		{
+			state = LynxLib::eWrongDataLength;
+			return 0;
+		}
+
+		if (((dataType & 0x80) != 0) && !writeReadOnly) // Read only
 			return transferSize;
 
+		if (valueChanged != LYNX_NULL)
+		{
+			*valueChanged = (_str->count() != (transferSize - 1));
+
+			for (int i = 1; (i < transferSize) && !(*valueChanged); i++)
+			{
+				*valueChanged = (_str->at(i - 1) != buffer[i]);
+			}
+		}
+
 		_str->clear();
-		_str->append(&buffer.at(startIndex + 1), (transferSize - 1));
+		_str->append(&buffer[1], (transferSize - 1));
+
+		return transferSize;
 	}
-	else
+
+	transferSize = this->transferSize();
+
+	if (transferSize > size)
 	{
-		transferSize = this->transferSize();
-		if ((_dataType & 0x80) != 0) // Read only
-			return transferSize;
+		state = LynxLib::eWrongDataLength;
+		return 0;
+	}
 
-		if (transferSize < 1) // Datatype not recognized
-		{
-			state = LynxLib::eDataTypeNotFound;
-			return 0;
-		}
+	if (((dataType & 0x80) != 0) && !writeReadOnly) // Read only
+		return transferSize;
+
+	if (LynxLib::isConverted(dataType))
+	{
+		float value = this->decodeConverted(uint16_t((int(buffer[0]) & 0xff) | ((int(buffer[1]) & 0xff) << 8)));
+
+		if (valueChanged != LYNX_NULL)
+			*valueChanged = (memcmp(&value, &_var->_var_float, sizeof(float)) != 0);
 
-		int localSize = this->localSize();
+		_var->_var_float = value;
 
-		LynxByteArray tempBuffer(transferSize);
-		buffer.subList(tempBuffer, startIndex, (startIndex + transferSize - 1));
+		return transferSize;
+	}
 
-		int count = LynxLib::mergeArray(tempBuffer, localSize);
+	if (_array != LYNX_NULL)
+	{
+		int width = LynxLib::transferSize(dataType);
+		char * elements = reinterpret_cast<char *>(_array);
 
-		if (count != localSize)
+		if (_endianness == LynxLib::eLittleEndian)
 		{
-			state = LynxLib::eMergeArrayFailed;
-			return transferSize;
-		}
+			if (valueChanged != LYNX_NULL)
+				*valueChanged = (memcmp(elements, buffer, transferSize) != 0);
 
-		switch (LynxType::endianness())
+			memcpy(elements, buffer, transferSize);
+		}
+		else
 		{
-		case LynxLib::eBigEndian:
-			for (int i = 0; i < localSize; i++)
-			{
-				_var->bytes[int(SIZE_64) - i - 1] = tempBuffer.at(i);
-			}
-			break;
-		case LynxLib::eLittleEndian:
-			for (int i = 0; i < localSize; i++)
+			for (int i = 0; i < transferSize; i += width)
 			{
-				_var->bytes[i] = tempBuffer.at(i);
+				for (int j = 0; j < width; j++)
+				{
+					if ((valueChanged != LYNX_NULL) && (elements[i + width - 1 - j] != buffer[i + j]))
+						*valueChanged = true;
+
+					elements[i + width - 1 - j] = buffer[i + j];
+				}
 			}
-			break;
-		default:
-			state = LynxLib::eEndiannessNotSet;
-			break;
 		}
+
+		return transferSize;
+	}
+
+	// The value is always transferred as little endian, regardless of the local endianness
+	uint64_t bits = 0;
+	for (int i = 0; i < transferSize; i++)
+	{
+		bits |= (uint64_t(buffer[i]) & 0xff) << (8 * i);
+	}
+
+	bool changed;
+
+	switch (transferSize)
+	{
+	case 1:
+		changed = (_var->_var_u8 != uint8_t(bits));
+		_var->_var_u8 = uint8_t(bits);
+		break;
+	case 2:
+		changed = (_var->_var_u16 != uint16_t(bits));
+		_var->_var_u16 = uint16_t(bits);
+		break;
+	case 4:
+		changed = (_var->_var_u32 != uint32_t(bits));
+		_var->_var_u32 = uint32_t(bits);
+		break;
+	case 8:
+		changed = (_var->_var_u64 != bits);
+		_var->_var_u64 = bits;
+		break;
+	default: // Datatype not recognized
+		state = LynxLib::eDataTypeNotFound;
+		return 0;
 	}
 
-    return transferSize;
+	if (valueChanged != LYNX_NULL)
+		*valueChanged = changed;
+
+	return transferSize;
 }
 
-int LynxType::localSize() const 
+int LynxType::snapshotSize() const
 {
-	if ((_dataType == LynxLib::eString_RW) || (_dataType == LynxLib::eString_RO))
-		return _str->count();
-	else
-		return LynxLib::localSize(_dataType);
+	if (LynxLib::isConverted(this->dataType()))
+		return int(sizeof(float));
+
+	return this->transferSize();
 }
 
-int LynxType::transferSize() const 
+int LynxType::toSnapshot(char * buffer, LynxLib::E_LynxState & state) const
 {
-	if ((_dataType == LynxLib::eString_RW) || (_dataType == LynxLib::eString_RO))
-		if (_str->count() > 255) // maximum string size
-			return 256;
-		else
-			return (_str->count() + 1); // Add one for the size specifier
+	if (!LynxLib::isConverted(this->dataType()))
+		return this->toArray(buffer, state);
+
+	// The bits of the float, little endian like every other value
+	for (int i = 0; i < 4; i++)
+	{
+		buffer[i] = char((_var->_var_u32 >> (8 * i)) & 0xff);
+	}
+
+	return 4;
+}
+
+int LynxType::fromSnapshot(const char * buffer, int size, LynxLib::E_LynxState & state, bool * valueChanged)
+{
+	if (!LynxLib::isConverted(this->dataType()))
+		return this->fromArray(buffer, size, state, true, valueChanged);
+
+	if (size < 4)
+	{
+		state = LynxLib::eWrongDataLength;
+		return 0;
+	}
+
+	uint32_t bits = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		bits |= (uint32_t(buffer[i]) & 0xff) << (8 * i);
+	}
+
+	if (valueChanged != LYNX_NULL)
+		*valueChanged = (_var->_var_u32 != bits);
+
+	_var->_var_u32 = bits;
+
+	return 4;
+}
+
+int LynxType::localSize() const 
+{
+	LynxLib::E_LynxDataType dataType = this->dataType();
+
+	if ((dataType == LynxLib::eString_RW) || (dataType == LynxLib::eString_RO))
+		return _str->count();
+	else if (this->arrayLength() > 0)
+		return _info->arrayLength * LynxLib::localSize(dataType);
+	else
+		return LynxLib::localSize(dataType);
+}
+
+int LynxType::transferSize() const 
+{
+	LynxLib::E_LynxDataType dataType = this->dataType();
+
+	if ((dataType == LynxLib::eString_RW) || (dataType == LynxLib::eString_RO))
+		if (_str->count() > 255) // maximum string size
+			return 256;
+		else
+			return (_str->count() + 1); // Add one for the size specifier
+	else if (this->arrayLength() > 0)
+		return _info->arrayLength * LynxLib::transferSize(dataType);
 	else
-		return LynxLib::transferSize(_dataType);
+		return LynxLib::transferSize(dataType);
 }
 
 //-----------------------------------------------------------------------------------------------------------
@@ -347,7 +789,7 @@ namespace LynxLib
 	int localSize(LynxLib::E_LynxDataType dataType)
 	{
 		// Remove the access specifier (bit 7), since we only care about the size
-		LynxLib::E_LynxDataType tmp = LynxLib::E_LynxDataType(dataType & 0x7f);
+		LynxLib::E_LynxDataType tmp = LynxLib::E_LynxDataType(elementType(dataType) & 0x7f);
 
 		switch (tmp)
 		{
@@ -373,6 +815,10 @@ namespace LynxLib
 			return sizeof(double);
 		case LynxLib::eBoolean_RW:
 			return sizeof(bool);
+		case LynxLib::eHalf_RW:
+			return sizeof(float);
+		case LynxLib::eScaled16_RW:
+			return sizeof(float);
 		default:
 			break;
 		}
@@ -383,7 +829,7 @@ namespace LynxLib
 	int transferSize(LynxLib::E_LynxDataType dataType)
 	{
 		// Remove the access specifier (bit 7), since we only care about the size
-		LynxLib::E_LynxDataType tmp = LynxLib::E_LynxDataType(dataType & 0x7f);
+		LynxLib::E_LynxDataType tmp = LynxLib::E_LynxDataType(elementType(dataType) & 0x7f);
 
 		switch (tmp)
 		{
@@ -409,6 +855,10 @@ namespace LynxLib
 			return 8;
 		case LynxLib::eBoolean_RW:
 			return 1;
+		case LynxLib::eHalf_RW:
+			return 2;
+		case LynxLib::eScaled16_RW:
+			return 2;
 		default:
 			break;
 		}
@@ -416,6 +866,123 @@ namespace LynxLib
 		return 0;
 	}
 
+	bool isArray(E_LynxDataType dataType)
+	{
+		E_LynxDataType tmp = E_LynxDataType(dataType & 0x7f);
+
+		return ((tmp >= eInt8Array_RW) && (tmp <= eDoubleArray_RW));
+	}
+
+	E_LynxDataType elementType(E_LynxDataType dataType)
+	{
+		if (!isArray(dataType))
+			return dataType;
+
+		// The array types are in the same order as the numeric types
+		return E_LynxDataType(dataType - (eInt8Array_RW - eInt8_RW));
+	}
+
+	E_LynxDataType arrayType(E_LynxDataType dataType)
+	{
+		E_LynxDataType tmp = E_LynxDataType(dataType & 0x7f);
+
+		if ((tmp < eInt8_RW) || (tmp > eDouble_RW))
+			return eNotInitialized;
+
+		return E_LynxDataType(dataType + (eInt8Array_RW - eInt8_RW));
+	}
+
+	bool isConverted(E_LynxDataType dataType)
+	{
+		E_LynxDataType tmp = E_LynxDataType(dataType & 0x7f);
+
+		return ((tmp == eHalf_RW) || (tmp == eScaled16_RW));
+	}
+
+	uint16_t floatToHalf(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+
+		uint16_t sign = uint16_t((bits >> 16) & 0x8000);
+		int32_t exponent = int32_t((bits >> 23) & 0xff) - 127 + 15;
+		uint32_t mantissa = bits & 0x7fffff;
+
+		if (((bits >> 23) & 0xff) == 0xff) // Infinity or NaN (NaN stays NaN)
+			return uint16_t(sign | 0x7c00 | ((mantissa != 0) ? 0x200 : 0));
+
+		if (exponent >= 0x1f) // Too large
+			return uint16_t(sign | 0x7c00);
+
+		uint32_t half;
+		uint32_t rest;
+		uint32_t halfway;
+
+		if (exponent <= 0) // Subnormal, or too small and rounded to zero
+		{
+			if (exponent < -10)
+				return sign;
+
+			int shift = 14 - exponent;
+			mantissa |= 0x800000;
+
+			half = mantissa >> shift;
+			rest = mantissa & ((uint32_t(1) << shift) - 1);
+			halfway = uint32_t(1) << (shift - 1);
+		}
+		else
+		{
+			half = (uint32_t(exponent) << 10) | (mantissa >> 13);
+			rest = mantissa & 0x1fff;
+			halfway = 0x1000;
+		}
+
+		// Round to nearest even. A carry out of the mantissa correctly increments the exponent (up to infinity).
+		if ((rest > halfway) || ((rest == halfway) && ((half & 1) != 0)))
+			half++;
+
+		return uint16_t(sign | half);
+	}
+
+	float halfToFloat(uint16_t half)
+	{
+		uint32_t sign = uint32_t(half & 0x8000) << 16;
+		int32_t exponent = (half >> 10) & 0x1f;
+		uint32_t mantissa = half & 0x3ff;
+		uint32_t bits;
+
+		if (exponent == 0x1f) // Infinity or NaN
+		{
+			bits = sign | 0x7f800000 | (mantissa << 13);
+		}
+		else if (exponent == 0)
+		{
+			if (mantissa == 0)
+			{
+				bits = sign;
+			}
+			else // Subnormal, normalized for the float
+			{
+				exponent = 1;
+				while ((mantissa & 0x400) == 0)
+				{
+					mantissa <<= 1;
+					exponent--;
+				}
+
+				bits = sign | (uint32_t(exponent - 15 + 127) << 23) | ((mantissa & 0x3ff) << 13);
+			}
+		}
+		else
+		{
+			bits = sign | (uint32_t(exponent - 15 + 127) << 23) | (mantissa << 13);
+		}
+
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
 	bool checkChecksum(const LynxByteArray & buffer)
 	{
 		char checksum = 0;
@@ -427,6 +994,20 @@ namespace LynxLib
 		return ((checksum & 0xff) == (buffer.last() & 0xff));
 	}
 
+	bool checkChecksum(const char * buffer, int size)
+	{
+		if (size < 1)
+			return false;
+
+		char checksum = 0;
+		for (int i = 0; i < (size - 1); i++)
+		{
+			checksum += buffer[i];
+		}
+
+		return ((checksum & 0xff) == (buffer[size - 1] & 0xff));
+	}
+
 	void addChecksum(LynxByteArray & buffer)
 	{
 		char checksum = 0;
@@ -438,6 +1019,17 @@ namespace LynxLib
 		buffer.append(checksum);
 	}
 
+	void addChecksum(char * buffer, int size)
+	{
+		char checksum = 0;
+		for (int i = 0; i < size; i++)
+		{
+			checksum += buffer[i];
+		}
+
+		buffer[size] = checksum;
+	}
+
 	void expandInt(int32_t input, LynxByteArray & buffer)
 	{
 		for (int i = 0; i < 4; i++)
@@ -465,7 +1057,337 @@ namespace LynxLib
 		return value;
 	}
 
+	int bitmapSize(int bitCount)
+	{
+		if (bitCount < 1)
+			return 0;
+
+		return ((bitCount - 1) / 8 + 1);
+	}
+
+	bool bitmapGet(const LynxByteArray & bitmap, int index)
+	{
+		if ((index < 0) || ((index / 8) >= bitmap.count()))
+			return false;
+
+		return ((bitmap.at(index / 8) & (char(1) << (index % 8))) != 0);
+	}
+
+	void bitmapSet(LynxByteArray & bitmap, int index, bool value)
+	{
+		if ((index < 0) || ((index / 8) >= bitmap.count()))
+			return;
+
+		if (value)
+			bitmap[index / 8] |= (char(1) << (index % 8));
+		else
+			bitmap[index / 8] &= ~(char(1) << (index % 8));
+	}
+
+	static void appendFloat(float value, LynxByteArray & buffer)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		expandInt(int32_t(bits), buffer);
+	}
+
+	static float readFloat(const char * buffer)
+	{
+		uint32_t bits = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			bits |= (uint32_t(buffer[i]) & 0xff) << (8 * i);
+		}
+
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	int deviceInfoSize(const LynxDeviceInfo & deviceInfo)
+	{
+		int dataLength = deviceInfo.description.count();		// Description (max 255)
+		dataLength += deviceInfo.lynxVersion.count();			// Version (max 255 (should not happen though, but you never know...))
+		dataLength += 4;										// Device Id + Description length + Version length + struct count;
+
+		for (int i = 0; i < deviceInfo.structs.count(); i++)
+		{
+			dataLength += deviceInfo.structs.at(i).description.count();			// Description (max 255)
+			dataLength += 3;													// structId + variableCount + Description length
+
+			for (int j = 0; j < deviceInfo.structs.at(i).variables.count(); j++)
+			{
+				dataLength += deviceInfo.structs.at(i).variables.at(j).description.count();	// Description (max 255)
+				dataLength += 3;															// index + data type + desc. length
+
+				if (isArray(deviceInfo.structs.at(i).variables.at(j).dataType))
+					dataLength += 2;														// Array length
+				else if ((deviceInfo.structs.at(i).variables.at(j).dataType & 0x7f) == eScaled16_RW)
+					dataLength += 8;														// Scale + offset
+			}
+		}
+
+		return dataLength;
+	}
+
+	void deviceInfoToArray(const LynxDeviceInfo & deviceInfo, LynxByteArray & buffer)
+	{
+		// ------------------------ Device Data -------------------------
+		// --------------------------------------------------------------
+		// |    Description    | Size |        Index       |  Contents  |
+		// --------------------------------------------------------------
+		// |   Device Id       |  1   |          0         |  0 -> 255  |
+		// | Device desc. len  |  1   |          1         |  0 -> 255  |
+		// |   Device desc.    |  b   |    2 -> (B - 1)    |     -      |
+		// |   Version len     |  1   |          B         |  0 -> 255  |
+		// |     Version       |  c   | (B + 1) -> (C - 1) |     -      |
+		// |   Struct count    |  1   |          C         |  0 -> 255  |
+		// |   Struct data     |  -   |     (C + 1) ->     |     -      |
+		// --------------------------------------------------------------
+		// b = Device desc. len
+		// B = 2 + b
+		// c = Version len
+		// C = B + 1 + c
+
+		buffer.append(deviceInfo.deviceId);					// Device id
+		buffer.append(char(deviceInfo.description.count()));	// Device desc. length
+		buffer.fromCharArray(deviceInfo.description.toCharArray(), deviceInfo.description.count());
+		buffer.append(char(deviceInfo.lynxVersion.count()));	// Version length
+		buffer.fromCharArray(deviceInfo.lynxVersion.toCharArray(), deviceInfo.lynxVersion.count());
+		buffer.append(char(deviceInfo.structCount));			// Struct count
+
+		// ---------------------------- Structs --------------------------------------
+		for (int i = 0; i < deviceInfo.structs.count(); i++)
+		{
+			// ------------------------ Struct Data -------------------------
+			// --------------------------------------------------------------
+			// |    Description    | Size |        Index       |  Contents  |
+			// --------------------------------------------------------------
+			// |    Struct Id      |  1   |          k         |  0 -> 255  |
+			// | Struct desc. len  |  1   |        k + 1       |  0 -> 255  |
+			// |   Struct desc.    |  d   | (k + 2) -> (D - 1) |     -      |
+			// |  Variable count   |  1   |          D         |  0 -> 255  |
+			// |  Variable data    |  -   |    (D + 1) -> E    |     -      |
+			// --------------------------------------------------------------
+			// k = C + 1 + i * struct size (variable) | where i is the struct indexer
+			// d = Struct desc. len
+			// D = k + 2 + d
+
+			const LynxStructInfo & structInfo = deviceInfo.structs.at(i);
+
+			buffer.append(structInfo.structId);						// Struct id
+			buffer.append(char(structInfo.description.count()));	// Struct desc. length
+			buffer.fromCharArray(structInfo.description.toCharArray(), structInfo.description.count());
+			buffer.append(char(structInfo.variableCount));			// Variable count
+
+			// ---------------------------- Variables --------------------------------------
+			for (int j = 0; j < structInfo.variables.count(); j++)
+			{
+				// ---------------------- Variable Data -------------------------
+				// --------------------------------------------------------------
+				// |    Description    | Size |        Index       |  Contents  |
+				// --------------------------------------------------------------
+				// |  Variable Index   |  1   |          p         |  0 -> 255  |
+				// |   Var desc. len   |  1   |        p + 1       |  0 -> 255  |
+				// |     Var desc.     |  e   | (p + 2) -> (E - 1) |     -      |
+				// |  Variable Type    |  1   |          E         |  0 -> 255  |
+				// |   Array length    |  2   | (E + 1) -> (E + 2) | 1 -> 65535 |
+				// |      Scale        |  4   | (E + 1) -> (E + 4) |   float    |
+				// |      Offset       |  4   | (E + 5) -> (E + 8) |   float    |
+				// --------------------------------------------------------------
+				// p = D + 1 + j * variable size (variable) | where j is the variable indexer
+				// e = Var desc. len
+				// E = p + 2 + e
+				// The array length is only there for array types, and the scale and offset only for eScaled16.
+				// All of them are little endian.
+
+				const LynxVariableInfo & variableInfo = structInfo.variables.at(j);
+
+				buffer.append(variableInfo.index);						// Variable index
+				buffer.append(char(variableInfo.description.count()));	// Variable desc. length
+				buffer.fromCharArray(variableInfo.description.toCharArray(), variableInfo.description.count());
+				buffer.append(char(variableInfo.dataType));				// Variable type
+
+				if (isArray(variableInfo.dataType))
+				{
+					buffer.append(char(variableInfo.arrayLength & 0xff));		// Array length
+					buffer.append(char((variableInfo.arrayLength >> 8) & 0xff));
+				}
+				else if ((variableInfo.dataType & 0x7f) == eScaled16_RW)
+				{
+					appendFloat(variableInfo.scale, buffer);					// Scale
+					appendFloat(variableInfo.offset, buffer);					// Offset
+				}
+			}
+		}
+	}
+
+	static int readInfoString(const char * buffer, int size, int & readIndex, LynxString & string)
+	{
+		if (readIndex >= size)
+			return -1;
+
+		int readLength = int(buffer[readIndex]) & 0xff;
+		readIndex++;
+
+		if ((readIndex + readLength) > size)
+			return -1;
+
+		string.clear();
+		string.append(&buffer[readIndex], readLength);
+		readIndex += readLength;
+
+		return readLength;
+	}
+
+	int deviceInfoFromArray(const char * buffer, int size, LynxDeviceInfo & deviceInfo)
+	{
+		// See deviceInfoToArray() for the layout
+		int readIndex = 0;
+
+		if (size < 1)
+			return -1;
+
+		deviceInfo.deviceId = buffer[readIndex];
+		readIndex++;
+
+		if (readInfoString(buffer, size, readIndex, deviceInfo.description) < 0)
+			return -1;
+		if (readInfoString(buffer, size, readIndex, deviceInfo.lynxVersion) < 0)
+			return -1;
+		if (readIndex >= size)
+			return -1;
+
+		deviceInfo.structCount = int(buffer[readIndex]) & 0xff;
+		readIndex++;
+
+		deviceInfo.structs.reserve(deviceInfo.structCount);
+
+		for (int i = 0; i < deviceInfo.structCount; i++)
+		{
+			if (readIndex >= size)
+				return -1;
+
+			LynxStructInfo & structInfo = deviceInfo.structs[deviceInfo.structs.append()];
+
+			structInfo.structId = buffer[readIndex];
+			readIndex++;
+
+			if (readInfoString(buffer, size, readIndex, structInfo.description) < 0)
+				return -1;
+			if (readIndex >= size)
+				return -1;
+
+			structInfo.variableCount = int(buffer[readIndex]) & 0xff;
+			readIndex++;
+
+			structInfo.variables.reserve(structInfo.variableCount);
+
+			for (int j = 0; j < structInfo.variableCount; j++)
+			{
+				if (readIndex >= size)
+					return -1;
+
+				LynxVariableInfo & variableInfo = structInfo.variables[structInfo.variables.append()];
+
+				variableInfo.index = buffer[readIndex];
+				readIndex++;
+
+				if (readInfoString(buffer, size, readIndex, variableInfo.description) < 0)
+					return -1;
+				if (readIndex >= size)
+					return -1;
+
+				variableInfo.dataType = LynxLib::E_LynxDataType(int(buffer[readIndex]) & 0xff);
+				readIndex++;
+
+				if (isArray(variableInfo.dataType))
+				{
+					if ((readIndex + 2) > size)
+						return -1;
+
+					variableInfo.arrayLength = (int(buffer[readIndex]) & 0xff) | ((int(buffer[readIndex + 1]) & 0xff) << 8);
+					readIndex += 2;
+				}
+				else if ((variableInfo.dataType & 0x7f) == eScaled16_RW)
+				{
+					if ((readIndex + 8) > size)
+						return -1;
+
+					variableInfo.scale = readFloat(&buffer[readIndex]);
+					variableInfo.offset = readFloat(&buffer[readIndex + 4]);
+					readIndex += 8;
+				}
+			}
+		}
+
+		return readIndex;
+	}
+
+	uint32_t hashBytes(uint32_t hash, const char * data, int size)
+	{
+		for (int i = 0; i < size; i++)
+		{
+			hash ^= (uint32_t(data[i]) & 0xff);
+			hash *= LYNX_HASH_PRIME;
+		}
+
+		return hash;
+	}
+
+	static uint32_t hashChar(uint32_t hash, char value)
+	{
+		return hashBytes(hash, &value, 1);
+	}
+
+	static uint32_t hashString(uint32_t hash, const LynxString & string)
+	{
+		// The length is hashed as well, so moving characters between neighbouring strings changes the result
+		hash = hashChar(hash, char(string.count()));
+		return hashBytes(hash, string.toCharArray(), string.count());
+	}
+
+	uint32_t schemaHash(const LynxDeviceInfo & deviceInfo, bool includeDescriptions)
+	{
+		uint32_t hash = hashChar(LYNX_HASH_SEED, char(includeDescriptions ? 1 : 0));
+
+		hash = hashString(hash, deviceInfo.lynxVersion);
+		if (includeDescriptions)
+			hash = hashString(hash, deviceInfo.description);
+
+		hash = hashChar(hash, char(deviceInfo.structs.count()));
+
+		for (int i = 0; i < deviceInfo.structs.count(); i++)
+		{
+			const LynxStructInfo & structInfo = deviceInfo.structs.at(i);
+
+			hash = hashChar(hash, structInfo.structId);
+			hash = hashChar(hash, char(structInfo.variables.count()));
+			if (includeDescriptions)
+				hash = hashString(hash, structInfo.description);
 
+			for (int j = 0; j < structInfo.variables.count(); j++)
+			{
+				hash = hashChar(hash, char(structInfo.variables.at(j).dataType));
+				if (isArray(structInfo.variables.at(j).dataType))
+				{
+					hash = hashChar(hash, char(structInfo.variables.at(j).arrayLength & 0xff));
+					hash = hashChar(hash, char((structInfo.variables.at(j).arrayLength >> 8) & 0xff));
+				}
+				else if ((structInfo.variables.at(j).dataType & 0x7f) == eScaled16_RW)
+				{
+					LynxByteArray scaling;
+					appendFloat(structInfo.variables.at(j).scale, scaling);
+					appendFloat(structInfo.variables.at(j).offset, scaling);
+					hash = hashBytes(hash, scaling.data(), scaling.count());
+				}
+				if (includeDescriptions)
+					hash = hashString(hash, structInfo.variables.at(j).description);
+			}
+		}
+
+		return hash;
+	}
 
 	int splitArray(LynxByteArray & buffer, int desiredSize)
 	{
@@ -569,6 +1491,9 @@ const LynxString LynxTextList::_lynxStates[LynxLib::eLynxState_EndOfList] =
 	"Periodic transmit started",
 	"Periodic transmit stopped",
     "Device id updated",
+	"Capabilities received",
+	"View defined",
+	"Schema hash received",
 	"Error separator",
 	"Out of sync",
 	"Struct id not found",
@@ -587,7 +1512,9 @@ const LynxString LynxTextList::_lynxStates[LynxLib::eLynxState_EndOfList] =
 	"Invalid struct id",
 	"Invalid internal id",
     "Data type not recognized",
-    "Invalid device id"
+    "Invalid device id",
+	"View id not found",
+	"View index out of bounds"
 };
 
 const LynxString LynxTextList::_lynxDataTypes[LynxLib::eLynxType_RW_EndOfList] =
@@ -604,7 +1531,19 @@ const LynxString LynxTextList::_lynxDataTypes[LynxLib::eLynxType_RW_EndOfList] =
 	"Float",
 	"Double",
 	"String",
-	"Boolean"
+	"Boolean",
+	"8 bit signed int array",
+	"8 bit unsigned int array",
+	"16 bit signed int array",
+	"16 bit unsigned int array",
+	"32 bit signed int array",
+	"32 bit unsigned int array",
+	"64 bit signed int array",
+	"64 bit unsigned int array",
+	"Float array",
+	"Double array",
+	"Half precision float",
+	"Scaled 16 bit fixed point"
 };
 
 LynxString LynxTextList::lynxState(LynxLib::E_LynxState state)
@@ -639,475 +1578,3168 @@ LynxString LynxTextList::lynxAccessSpecifier(LynxLib::E_LynxDataType dataType)
 //---------------------------------------- LynxStructure ----------------------------------------------------
 //-----------------------------------------------------------------------------------------------------------
 
-LynxStructure::LynxStructure() : LynxList()
+#ifdef LYNX_MULTITHREAD
+// Number of failed attempts before a waiting thread starts yielding its time slice
+#define LYNX_LOCK_SPIN_COUNT 64
+
+void LynxReadWriteLock::lockRead()
 {
-	_description = LYNX_NULL;
-	_structId = -1;
-	_enableReadOnly = false;
+	// Nested inside our own write lock
+	if (_writer.load(std::memory_order_relaxed) == std::this_thread::get_id())
+	{
+		_writeDepth++;
+		return;
+	}
+
+	for (int spin = 0; ; spin++)
+	{
+		int32_t state = _state.load(std::memory_order_relaxed);
+
+		if ((state >= 0) && _state.compare_exchange_weak(state, state + 1, std::memory_order_acquire, std::memory_order_relaxed))
+			return;
+
+		if (spin >= LYNX_LOCK_SPIN_COUNT)
+			std::this_thread::yield();
+	}
 }
 
-LynxStructure::~LynxStructure()
+void LynxReadWriteLock::unlockRead()
 {
-	if (_description != LYNX_NULL)
-	{ 
-		delete _description;
-		_description = LYNX_NULL;
+	if (_writer.load(std::memory_order_relaxed) == std::this_thread::get_id())
+	{
+		_writeDepth--;
+		return;
 	}
+
+	_state.fetch_sub(1, std::memory_order_release);
 }
 
-void LynxStructure::init(char structId, const LynxString * const description, bool enableReadOnly, int size)
+void LynxReadWriteLock::lockWrite()
 {
-	_enableReadOnly = enableReadOnly;
+	if (_writer.load(std::memory_order_relaxed) == std::this_thread::get_id())
+	{
+		_writeDepth++;
+		return;
+	}
 
-	LynxList::reserve(size);
+	for (int spin = 0; ; spin++)
+	{
+		int32_t state = 0;
 
-	_structId = structId;
+		if (_state.compare_exchange_weak(state, -1, std::memory_order_acquire, std::memory_order_relaxed))
+			break;
 
-	if (_description != LYNX_NULL)
-		delete _description;
-		
-        if (description == LYNX_NULL)
-        return;
-	if (description->isEmpty())
-		return;
+		if (spin >= LYNX_LOCK_SPIN_COUNT)
+			std::this_thread::yield();
+	}
 
-	_description = new LynxString(*description);
+	_writer.store(std::this_thread::get_id(), std::memory_order_relaxed);
+	_writeDepth = 1;
 }
 
-void LynxStructure::getInfo(LynxStructInfo & structInfo) const
+void LynxReadWriteLock::unlockWrite()
 {
-	structInfo.structId = _structId;
-	structInfo.variableCount = _count;
+	if (--_writeDepth > 0)
+		return;
 
-	if (_description == LYNX_NULL)
-		structInfo.description = "Not defined";
-	else
-		structInfo.description = *_description;
+	_writer.store(std::thread::id(), std::memory_order_relaxed);
+	_state.store(0, std::memory_order_release);
+}
+#endif // LYNX_MULTITHREAD
 
-	structInfo.variables.reserve(_count);
-	for (int i = 0; i < _count; i++)
-	{
-		structInfo.variables.append();
-        structInfo.variables[i].index = char(i);
-		structInfo.variables[i].dataType = _data[i].dataType();
-		structInfo.variables[i].description = _data[i].description();
-	}
+static bool validDataType(LynxLib::E_LynxDataType dataType)
+{
+	return !(
+		((dataType <= LynxLib::eNotInitialized) || (dataType >= LynxLib::eLynxType_RW_EndOfList)) &&
+		((dataType <= LynxLib::eLynxType_RO_StartOfList) || (dataType >= LynxLib::eLynxType_RO_EndOfList))
+		);
 }
 
-LynxStructInfo LynxStructure::getInfo() const
+// Array types need a length whose data fits in a range datagram, other types must not have one
+static bool validArrayLength(LynxLib::E_LynxDataType dataType, int arrayLength)
 {
-	LynxStructInfo temp;
-	this->getInfo(temp);
-	return temp;
+	if (!LynxLib::isArray(dataType))
+		return (arrayLength == 0);
+
+	return ((arrayLength > 0) && ((arrayLength * LynxLib::transferSize(dataType)) <= 0xffff));
 }
 
-LynxLib::E_LynxState LynxStructure::toArray(LynxByteArray & buffer, int variableIndex) const
+// The scaling of eScaled16 must be usable, other types ignore it
+static bool validScaling(const LynxVariableInfo & variableInfo)
 {
-	if (_count < 1)
-		return LynxLib::eNoStructuresInList;
-	else if (variableIndex >= _count)
-		return LynxLib::eVariableIndexOutOfBounds;
+	if ((variableInfo.dataType & 0x7f) != LynxLib::eScaled16_RW)
+		return true;
 
-	LynxLib::E_LynxState state = LynxLib::eDataCopiedToBuffer;
+	return ((variableInfo.scale != 0.0f) && finiteFloat(variableInfo.scale) && finiteFloat(variableInfo.offset));
+}
 
-	if (variableIndex < 0) // All variables
-	{
-		for (int i = 0; i < _count; i++)
-		{
-            _data[i].toArray(buffer, state);
-		}
-	}
-	else // Single variable
+// Stores the data type as the structure uses it, and leaves out what the data type doesn't use
+static void normalizeVariable(LynxVariableInfo & variableInfo, int index, bool enableReadOnly)
+{
+	variableInfo.index = char(index);
+
+	if (!enableReadOnly)
+		variableInfo.dataType = LynxLib::E_LynxDataType(variableInfo.dataType & 0x7f); // Remove read only specifier
+
+	if (!LynxLib::isArray(LynxLib::E_LynxDataType(variableInfo.dataType & 0x7f)))
+		variableInfo.arrayLength = 0;
+
+	if ((variableInfo.dataType & 0x7f) != LynxLib::eScaled16_RW)
 	{
-        _data[variableIndex].toArray(buffer, state);
+		variableInfo.scale = 1.0f;
+		variableInfo.offset = 0.0f;
 	}
-
-    return state;
 }
 
-LynxLib::E_LynxState LynxStructure::toArray(char * buffer, int maxSize, int & copiedSize, int variableIndex) const
+// The wire format is little endian, so on little endian hosts a value can be copied straight from its LynxUnion
+static bool littleEndianHost()
 {
-	LynxByteArray temp;
-	LynxLib::E_LynxState state = this->toArray(temp, variableIndex);
+	LynxUnion probe;
+	probe._var_u64 = 1;
+	return (probe._var_u8 == 1);
+}
 
-	if (state != LynxLib::eDataCopiedToBuffer)
+template <int width>
+static void encodeRun(char * buffer, const LynxUnion * values, int count)
+{
+	for (int i = 0; i < count; i++)
 	{
-		copiedSize = 0;
-		return state;
+		memcpy(&buffer[i * width], &values[i], width);
 	}
+}
 
-	copiedSize = temp.toCharArray(buffer, maxSize);
-	if (copiedSize < 0)
+template <int width>
+static void decodeRun(const char * buffer, LynxUnion * values, int count)
+{
+	for (int i = 0; i < count; i++)
 	{
-		copiedSize = 0;
-		return LynxLib::eBufferTooSmall;
+		memcpy(&values[i], &buffer[i * width], width);
 	}
+}
 
-	return state;
+// Same as decodeRun(), but marks the variables whose bytes differ in received (firstIndex is the index of values[0])
+static void decodeRunCompare(const char * buffer, LynxUnion * values, int count, int width, LynxByteArray & received, int firstIndex)
+{
+	for (int i = 0; i < count; i++)
+	{
+		if (memcmp(&values[i], &buffer[i * width], width) == 0)
+			continue;
+
+		memcpy(&values[i], &buffer[i * width], width);
+		LynxLib::bitmapSet(received, firstIndex + i, true);
+	}
 }
 
-void LynxStructure::fromArray(const LynxByteArray & buffer, LynxInfo & lynxInfo)
+LynxStructure::LynxStructure() : LynxList()
 {
-    int bufferIndex = LYNX_HEADER_BYTES;
+	_description = LYNX_NULL;
+	_structId = -1;
+	_enableReadOnly = false;
+	_schema = LYNX_NULL;
+	_ownsSchema = false;
+	_concurrencyMode = LynxLib::eNoConcurrency;
+	_threadSafe = false;
+	_values = LYNX_NULL;
+	_boundCount = 0;
+	_frozen = false;
+	_planStrings = false;
+	_fixedTransferSize = 0;
+	_fixedLocalSize = 0;
+	_changeStamp = 1;
+
+#ifdef LYNX_MULTITHREAD
+	_sequence.store(0, std::memory_order_relaxed);
+	_writeNesting = 0;
+	_buffers = LYNX_NULL;
+	_bufferCount = 0;
+	_writeBuffer = 0;
+	_readBuffer = 1;
+	_publishedBuffer.store(2, std::memory_order_relaxed);
+#endif // LYNX_MULTITHREAD
+}
 
-    lynxInfo.state = LynxLib::eNewDataReceived;
+LynxStructure::~LynxStructure()
+{
+	if (_description != LYNX_NULL)
+	{ 
+		delete _description;
+		_description = LYNX_NULL;
+	}
 
-    if (lynxInfo.lynxId.variableIndex < 0) // All variables
+	// The variables don't own their values, so this is safe before the list is destroyed
+	if (_values != LYNX_NULL)
 	{
-		for (int i = 0; i < _count; i++)
-		{
-            bufferIndex += _data[i].fromArray(buffer, bufferIndex, lynxInfo.state);
-		}
+		delete[] _values;
+		_values = LYNX_NULL;
 	}
-    else if (lynxInfo.lynxId.variableIndex > _count) // Invalid index
+
+#ifdef LYNX_MULTITHREAD
+	if (_buffers != LYNX_NULL)
 	{
-        lynxInfo.state = LynxLib::eVariableIndexOutOfBounds;
-        return;
+		delete[] _buffers;
+		_buffers = LYNX_NULL;
 	}
-	else // Single variable
+#endif // LYNX_MULTITHREAD
+
+	// The variables never look at their info when they are destroyed
+	if (_ownsSchema)
 	{
-        bufferIndex += _data[lynxInfo.lynxId.variableIndex].fromArray(buffer, bufferIndex, lynxInfo.state);
+		delete _schema;
+		_schema = LYNX_NULL;
 	}
 }
 
-void LynxStructure::fromArray(const char * buffer, int size, LynxInfo & lynxInfo)
+void LynxStructure::init(char structId, const LynxString * const description, bool enableReadOnly, int size)
 {
-    this->fromArray(LynxByteArray(buffer, size), lynxInfo);
+	this->initStructure(structId, description, enableReadOnly, size, LYNX_NULL);
 }
 
-LynxId LynxStructure::addVariable(int structIndex, LynxLib::E_LynxDataType dataType, const LynxString & description)
+void LynxStructure::initStructure(char structId, const LynxString * const description, bool enableReadOnly, int size, LynxStructInfo * schema)
 {
-	if (!_enableReadOnly)
-		dataType = LynxLib::E_LynxDataType(dataType & 0x7f); // Remove read only specifier
+	_enableReadOnly = enableReadOnly;
 
-	if (
-		((dataType <= LynxLib::eNotInitialized) || (dataType >= LynxLib::eLynxType_RW_EndOfList)) &&
-		((dataType <= LynxLib::eLynxType_RO_StartOfList) || (dataType >= LynxLib::eLynxType_RO_EndOfList))
-		)
-		return LynxId();
+	this->useSchema(schema);
 
-	this->append();
-	this->last().init(dataType, &description);
+	if (_ownsSchema)
+		_schema->variables.reserve(size);
 
-	//_transferSize += this->last().transferSize();
-	//_localSize += this->last().localSize();
+	LynxList::reserve(size);
+	_changed.reserve(LynxLib::bitmapSize(size));
+	_changeStamps.reserve(size);
+	_received.reserve(LynxLib::bitmapSize(size));
 
-	return LynxId(structIndex, (_count - 1));
-}
+	_structId = structId;
 
-int LynxStructure::transferSize(int index) const
-{
-	if (index < 0) // All variables
-	{
-		int tempSize = 0;
+	this->clearPlan();
 
-		for (int i = 0; i < _count; i++)
-		{
-			tempSize += _data[i].transferSize();
-		}
+	_fixedTransferSize = 0;
+	_fixedLocalSize = 0;
+	_stringIndexes.clear();
+	_boundCount = 0;
 
-        return tempSize;
-	}
-	else if (index >= _count) // Out of bounds
-	{
-		return 0;
-	}
-	else // Single variable
+	if (_description != LYNX_NULL)
 	{
-		return _data[index].transferSize();
+		delete _description;
+		_description = LYNX_NULL;
 	}
+		
+        if (description == LYNX_NULL)
+        return;
+	if (description->isEmpty())
+		return;
+
+	_description = new LynxString(*description);
 }
 
-int LynxStructure::localSize(int variableIndex) const
+bool LynxStructure::init(const LynxStructInfo & structInfo, bool enableReadOnly)
 {
-	if (variableIndex < 0) // All variables
+	this->init(structInfo.structId, &structInfo.description, enableReadOnly, structInfo.variables.count());
+
+	return this->initVariables(structInfo);
+}
+
+bool LynxStructure::init(char structId, const LynxString & description, LynxStructInfo & schema, bool enableReadOnly)
+{
+	this->initStructure(structId, &description, enableReadOnly, schema.variables.count(), &schema);
+
+	return this->initVariables(schema);
+}
+
+bool LynxStructure::initVariables(const LynxStructInfo & structInfo)
+{
+	for (int i = 0; i < structInfo.variables.count(); i++)
 	{
-		int tempSize = 0;
+		const LynxVariableInfo & variableInfo = structInfo.variables.at(i);
+		LynxLib::E_LynxDataType dataType = variableInfo.dataType;
 
-		for (int i = 0; i < _count; i++)
+		if (!_enableReadOnly)
+			dataType = LynxLib::E_LynxDataType(dataType & 0x7f); // Remove read only specifier
+
+		if (!validDataType(dataType) || !validArrayLength(dataType, variableInfo.arrayLength) || !validScaling(variableInfo))
+			return false;
+
+		// A shared schema is used as it is, otherwise the variable gets an entry in the schema of the structure
+		if (_ownsSchema)
 		{
-			tempSize += _data[i].localSize();
+			_schema->variables.append(variableInfo);
+			normalizeVariable(_schema->variables.last(), i, _enableReadOnly);
 		}
 
-		return tempSize;
+		// Room for all the variables was reserved by init(), so neither list reallocates
+		this->append();
+		this->last().init(&_schema->variables[i]);
+
+		this->cacheSizes(_count - 1);
 	}
-	else if (variableIndex >= _count) // Out of bounds
+
+	for (int i = 0; i < LynxLib::bitmapSize(_count); i++)
 	{
-		return 0;
+		_changed.append(char(0));
+		_received.append(char(0));
 	}
-	else // Single variable
+
+	for (int i = 0; i < _count; i++)
 	{
-		return _data[variableIndex].localSize();
+		_changeStamps.append(0);
 	}
-}
 
-LynxString LynxStructure::description() const
-{
-	if(_description == LYNX_NULL)
-		return LynxString();
+	this->bindValues();
 
-	return *_description;
+	return true;
 }
 
-//-----------------------------------------------------------------------------------------------------------
-//----------------------------------------- LynxManager -----------------------------------------------------
-//-----------------------------------------------------------------------------------------------------------
-
-LynxManager::LynxManager(char deviceId, const LynxString & description, int size) : LynxList(size), _version(LYNX_VERSION)
-{ 
-	_deviceId = deviceId;
-		
-	if (description.isEmpty())
-		return;
-
-	_description = new LynxString(description);
+void LynxStructure::bindInfos()
+{
+	for (int i = 0; i < _count; i++)
+	{
+		_data[i].shareInfo(&_schema->variables[i]);
+	}
 }
 
-LynxManager::~LynxManager()
+void LynxStructure::useSchema(LynxStructInfo * schema)
 {
-	if (_description != LYNX_NULL)
+	if (_ownsSchema)
 	{
-		delete _description;
-		_description = LYNX_NULL;
+		if (schema == LYNX_NULL) // Keeps its own
+			return;
+
+		delete _schema;
+	}
+
+	if (schema == LYNX_NULL)
+	{
+		_schema = new LynxStructInfo();
+		_ownsSchema = true;
+		return;
 	}
+
+	_schema = schema;
+	_ownsSchema = false;
 }
 
-void LynxManager::getInfo(LynxDeviceInfo & deviceInfo) const
+void LynxStructure::getInfo(LynxStructInfo & structInfo) const
 {
-	deviceInfo.deviceId = _deviceId;
-	deviceInfo.structCount = _count;
-	deviceInfo.lynxVersion = _version;
-		
+	structInfo.structId = _structId;
+	structInfo.variableCount = _count;
+
 	if (_description == LYNX_NULL)
-		deviceInfo.description = "Not defined";
+		structInfo.description = "Not defined";
 	else
-		deviceInfo.description = *_description;
+		structInfo.description = *_description;
 
-	deviceInfo.structs.reserve(_count);
+	structInfo.variables.reserve(_count);
 	for (int i = 0; i < _count; i++)
 	{
-		deviceInfo.structs.append();
-		_data[i].getInfo(deviceInfo.structs[i]);
+		structInfo.variables.append();
+        structInfo.variables[i].index = char(i);
+		structInfo.variables[i].dataType = _data[i].dataType();
+		structInfo.variables[i].description = _data[i].description();
+		structInfo.variables[i].arrayLength = _data[i].arrayLength();
+		structInfo.variables[i].scale = _data[i].scale();
+		structInfo.variables[i].offset = _data[i].offset();
 	}
 }
 
-LynxDeviceInfo LynxManager::getInfo() const
+LynxStructInfo LynxStructure::getInfo() const
 {
-	LynxDeviceInfo temp;
+	LynxStructInfo temp;
 	this->getInfo(temp);
 	return temp;
 }
 
-char LynxManager::structId(const LynxId & lynxId) const
+LynxLib::E_LynxState LynxStructure::toArray(LynxByteArray & buffer, int variableIndex) const
 {
-    if((lynxId.structIndex < 0) || (lynxId.structIndex > _count))
-        return LYNX_INVALID_DATAGRAM;
+	int startIndex = buffer.count();
+	int copiedSize;
+	int transferSize = this->transferSize(variableIndex);
 
-    return _data[lynxId.structIndex].structId();
-}
+	LynxLib::E_LynxState state = this->toArray(buffer.extend(transferSize), transferSize, copiedSize, variableIndex);
 
-LynxString LynxManager::getStructName(const LynxId & lynxId)
-{
-    if ((lynxId.structIndex < 0) || (lynxId.structIndex >= _count))
-        return LynxString();
+	if (copiedSize < 1)
+		buffer.remove(startIndex, buffer.count() - 1);
 
-    return _data[lynxId.structIndex].description();
+	return state;
 }
 
-LynxString LynxManager::getVariableName(const LynxId & lynxId)
+LynxLib::E_LynxState LynxStructure::toArray(char * buffer, int maxSize, int & copiedSize, int variableIndex) const
 {
-    if ((lynxId.structIndex < 0) || (lynxId.structIndex >= _count))
-        return LynxString();
+	copiedSize = 0;
 
-    if ((lynxId.variableIndex < 0) || (lynxId.variableIndex >= _data[lynxId.structIndex].count()))
-        return LynxString();
-
-    return _data[lynxId.structIndex].at(lynxId.variableIndex).description();
-}
+	if (_count < 1)
+		return LynxLib::eNoStructuresInList;
+	else if (variableIndex >= _count)
+		return LynxLib::eVariableIndexOutOfBounds;
 
-LynxType & LynxManager::variable(const LynxId & lynxId)
-{
-	return (*this)[lynxId.structIndex][lynxId.variableIndex];
-}
+	if (variableIndex < 0) // All variables
+		return this->toArray(buffer, maxSize, copiedSize, 0, _count);
 
-const LynxType & LynxManager::variable(const LynxId & lynxId) const
-{
-	return this->at(lynxId.structIndex).at(lynxId.variableIndex);
+	return this->toArray(buffer, maxSize, copiedSize, variableIndex, 1);
 }
 
-void LynxManager::copy(const LynxId & source, const LynxId & target)
+LynxLib::E_LynxState LynxStructure::toArray(LynxByteArray & buffer, int startIndex, int variableCount) const
 {
-	if ((source.variableIndex < 0) || (target.variableIndex < 0))
-		return;
-		
-	_data[target.structIndex][target.variableIndex] = _data[source.structIndex].at(source.variableIndex);
-}
+	int bufferIndex = buffer.count();
+	int copiedSize;
+	int transferSize = this->transferSize(startIndex, variableCount);
 
-LynxLib::E_LynxState LynxManager::toArray(LynxByteArray & buffer, const LynxId & lynxId) const
-{
-	// |  Description   |    Size    |     Index    | Contents |
-	// ---------------------------------------------------------
-	// | Static header  |     1      |       0      |   'A'    |
-	// |   Struct Id    |     1      |       1      | 0 -> 254 |
-	// | Variable index |     1      |       2      | 0 -> 255 |
-	// |  Data length   |     1      |       3      | 0 -> 255 |
-	// |   Device Id    |     1      |       4      | 0 -> 255 |
-	// |     Data       | dataLength | 5 -> (n - 2) |    -     |
-	// |   Checksum     |     1      |    (n - 1)   | 0 -> 255 |
+	LynxLib::E_LynxState state = this->toArray(buffer.extend(transferSize), transferSize, copiedSize, startIndex, variableCount);
 
-	// n = 5 + dataLength + 1
+	if (copiedSize < 1)
+		buffer.remove(bufferIndex, buffer.count() - 1);
 
-	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= _count))
-		return LynxLib::eStructIndexOutOfBounds;
+	return state;
+}
 
-	int dataLength = _data[lynxId.structIndex].transferSize(lynxId.variableIndex);
+LynxLib::E_LynxState LynxStructure::toArray(char * buffer, int maxSize, int & copiedSize, int startIndex, int variableCount) const
+{
+	copiedSize = 0;
 
-	if (dataLength < 1)
-		return LynxLib::eDataLengthNotFound;
+	if (_count < 1)
+		return LynxLib::eNoStructuresInList;
+	else if ((startIndex < 0) || (variableCount < 1) || ((startIndex + variableCount) > _count))
+		return LynxLib::eVariableIndexOutOfBounds;
 
-	buffer.reserve(dataLength + LYNX_HEADER_BYTES + LYNX_CHECKSUM_BYTES);
-	buffer.append(LYNX_STATIC_HEADER);
-	buffer.append(_data[lynxId.structIndex].structId());
-	buffer.append(static_cast<char>(lynxId.variableIndex + 1));
-	buffer.append(static_cast<char>(dataLength));
-	buffer.append(_deviceId);
+	if (this->transferSize(startIndex, variableCount) > maxSize)
+		return LynxLib::eBufferTooSmall;
 
-	LynxLib::E_LynxState state = _data[lynxId.structIndex].toArray(buffer, lynxId.variableIndex);
+	LynxLib::E_LynxState state = LynxLib::eDataCopiedToBuffer;
 
-	if (state != LynxLib::eDataCopiedToBuffer)
+	if (_frozen)
+	{
+		copiedSize = this->encodePlan(buffer, startIndex, variableCount, state);
 		return state;
+	}
 
-	LynxLib::addChecksum(buffer);
+	for (int i = startIndex; i < (startIndex + variableCount); i++)
+	{
+		copiedSize += _data[i].toArray(&buffer[copiedSize], state);
+	}
 
 	return state;
 }
 
-LynxLib::E_LynxState LynxManager::toArray(char * buffer, int maxSize, int & copiedSize, const LynxId & lynxId) const
+LynxLib::E_LynxState LynxStructure::toArray(LynxByteArray & buffer, const LynxByteArray & variableMask) const
 {
-	LynxByteArray temp;
-	LynxLib::E_LynxState state = this->toArray(temp, lynxId);
+	int startIndex = buffer.count();
+	int copiedSize;
+	int transferSize = this->transferSize(variableMask);
 
-	if (state != LynxLib::eDataCopiedToBuffer)
-	{
-		copiedSize = 0;
-		return state;
-	}
+	LynxLib::E_LynxState state = this->toArray(buffer.extend(transferSize), transferSize, copiedSize, variableMask);
 
-	copiedSize = temp.toCharArray(buffer, maxSize);
-	if (copiedSize < 0)
-	{
-		copiedSize = 0;
-        return LynxLib::eBufferTooSmall;
-	}
+	if (copiedSize < 1)
+		buffer.remove(startIndex, buffer.count() - 1);
 
 	return state;
 }
 
-void LynxManager::fromArray(const LynxByteArray & buffer, LynxInfo & lynxInfo)
+LynxLib::E_LynxState LynxStructure::toArray(char * buffer, int maxSize, int & copiedSize, const LynxByteArray & variableMask) const
 {
-	lynxInfo.lynxId.structIndex = this->findId(buffer.at(1));
-	lynxInfo.lynxId.variableIndex = (int(buffer.at(2)) & 0xff) - 1;
-	lynxInfo.dataLength = int(buffer.at(3)) & 0xff;
-	lynxInfo.deviceId = buffer.at(4);
+	copiedSize = 0;
 
-	// Check the struct ID
-	if (lynxInfo.lynxId.structIndex < 0)
+	if (_count < 1)
+		return LynxLib::eNoStructuresInList;
+
+	if (this->transferSize(variableMask) > maxSize)
+		return LynxLib::eBufferTooSmall;
+
+	LynxLib::E_LynxState state = LynxLib::eDataCopiedToBuffer;
+
+	for (int i = 0; i < _count; i++)
 	{
-		lynxInfo.state = LynxLib::eStructIdNotFound;
-		return;
+		if (LynxLib::bitmapGet(variableMask, i))
+			copiedSize += _data[i].toArray(&buffer[copiedSize], state);
 	}
 
-	// Check the variable index
-	if (lynxInfo.lynxId.variableIndex > _data[lynxInfo.lynxId.structIndex].count())
+	return state;
+}
+
+void LynxStructure::fromArray(const LynxByteArray & buffer, LynxInfo & lynxInfo)
+{
+	this->fromArray(buffer.data(), buffer.count(), lynxInfo);
+}
+
+void LynxStructure::fromArray(const char * buffer, int size, LynxInfo & lynxInfo)
+{
+	int headerBytes = LYNX_HEADER_BYTES;
+	bool delta = false;
+
+	if ((size > 2) && (buffer[1] == LYNX_INTERNALS_HEADER))
 	{
-		lynxInfo.state = LynxLib::eVariableIndexOutOfBounds;
-		return;
+		if (LynxLib::E_LynxInternals(int(buffer[2]) & 0xff) == LynxLib::eRangeDatagram)
+		{
+			headerBytes = LYNX_RANGE_HEADER_BYTES;
+		}
+		else
+		{
+			headerBytes = LYNX_DELTA_HEADER_BYTES;
+			delta = true;
+		}
 	}
 
-	// Check the total size
-	int totalSize = lynxInfo.dataLength + LYNX_HEADER_BYTES + LYNX_CHECKSUM_BYTES;
-	if (buffer.count() < totalSize)
+	int dataLength = lynxInfo.dataLength;
+	if (dataLength > (size - headerBytes))
+		dataLength = size - headerBytes;
+
+	if (dataLength < 0)
 	{
 		lynxInfo.state = LynxLib::eBufferTooSmall;
 		return;
 	}
-		
-	// Check the checksum
-	if (!LynxLib::checkChecksum(buffer))
+
+#ifdef LYNX_MULTITHREAD
+	// Readers of latest() must never see a partly applied frame, so the frame is checked before anything is written
+	if (_concurrencyMode == LynxLib::eDoubleBuffer)
 	{
-		lynxInfo.state = LynxLib::eWrongChecksum;
-		return;
+		lynxInfo.state = this->checkData(&buffer[headerBytes], dataLength, lynxInfo, delta, true);
+
+		if (lynxInfo.state >= LynxLib::eErrors)
+			return;
 	}
+#endif // LYNX_MULTITHREAD
 
-	// Copy the data
-    _data[lynxInfo.lynxId.structIndex].fromArray(buffer, lynxInfo);
+	this->beginWrite();
+
+	int readSize;
+
+	if (delta)
+		readSize = this->readDelta(&buffer[headerBytes], dataLength, lynxInfo);
+	else
+		readSize = this->readData(&buffer[headerBytes], dataLength, lynxInfo);
+
+	this->endWrite();
+
+	// The frame must hold exactly the variables it addresses
+	if ((lynxInfo.state < LynxLib::eErrors) && (readSize != dataLength))
+		lynxInfo.state = LynxLib::eWrongDataLength;
+
+	// Only frames that decoded without errors are handed to the readers
+	if (lynxInfo.state < LynxLib::eErrors)
+		this->publish();
+
+	// The variables read before an error have changed all the same
+	this->notify();
 }
 
-void LynxManager::fromArray(const char * buffer, int size, LynxInfo & lynxInfo)
+int LynxStructure::fromData(const char * data, int dataLength, LynxInfo & lynxInfo)
 {
-	LynxByteArray temp(buffer, size);
+#ifdef LYNX_MULTITHREAD
+	// See fromArray()
+	if (_concurrencyMode == LynxLib::eDoubleBuffer)
+	{
+		lynxInfo.state = this->checkData(data, dataLength, lynxInfo, false, false);
+
+		if (lynxInfo.state >= LynxLib::eErrors)
+			return 0;
+	}
+#endif // LYNX_MULTITHREAD
+
+	this->beginWrite();
+	int readSize = this->readData(data, dataLength, lynxInfo);
+	this->endWrite();
+
+	if (lynxInfo.state < LynxLib::eErrors)
+		this->publish();
+
+	this->notify();
 
-	this->fromArray(temp, lynxInfo);
+	return readSize;
 }
 
-int LynxManager::transferSize(const LynxId & lynxId) const
+int LynxStructure::snapshotSize() const
 {
-	return _data[lynxId.structIndex].transferSize(lynxId.variableIndex);
+	int size = 0;
+
+	for (int i = 0; i < _count; i++)
+	{
+		size += _data[i].snapshotSize();
+	}
+
+	return size;
 }
 
-int LynxManager::localSize(const LynxId & lynxId) const
+LynxLib::E_LynxState LynxStructure::toSnapshot(LynxByteArray & buffer) const
 {
-	return _data[lynxId.structIndex].localSize(lynxId.variableIndex);
+	if (_count < 1)
+		return LynxLib::eNoStructuresInList;
+
+	LynxLib::E_LynxState state = LynxLib::eDataCopiedToBuffer;
+	char * data = buffer.extend(this->snapshotSize());
+	int copiedSize = 0;
+
+	for (int i = 0; i < _count; i++)
+	{
+		copiedSize += _data[i].toSnapshot(&data[copiedSize], state);
+	}
+
+	return state;
 }
 
-LynxId LynxManager::addStructure(char structId, const LynxString & description, bool enableReadOnly, int size)
+int LynxStructure::fromSnapshot(const char * data, int dataLength, LynxInfo & lynxInfo)
 {
+	// Not checked before writing in double buffer mode like fromArray(), since snapshots are always read into
+	// the structures of a new manager (see LynxManager::loadSnapshot()), which are dropped if reading fails
+	int dataIndex = 0;
+
+	lynxInfo.state = LynxLib::eNewDataReceived;
+
+	bool valueChanged = false;
+	bool * compare = (_subscriptions.count() > 0) ? &valueChanged : LYNX_NULL;
+
+	// Always one variable at a time, since the frozen plan only knows the wire layout
+	this->beginWrite();
+
 	for (int i = 0; i < _count; i++)
 	{
-		if ((_data[i].structId() == structId) || (_data[i].description() == description))
-			return LynxId();
+		int readSize = _data[i].fromSnapshot(&data[dataIndex], dataLength - dataIndex, lynxInfo.state, compare);
+
+		if (valueChanged)
+			LynxLib::bitmapSet(_received, i, true);
+
+		if (readSize < 1)
+			break;
+
+		dataIndex += readSize;
 	}
 
-	LynxId temp;
-	temp.structIndex = this->append();
-	this->last().init(structId, &description, enableReadOnly, size);
+	this->endWrite();
 
-	return temp;
+	if (lynxInfo.state < LynxLib::eErrors)
+		this->publish();
+
+	this->notify();
+
+	return dataIndex;
 }
 
-LynxDynamicId LynxManager::addStructure(const LynxStructInfo & structInfo, bool enableReadOnly)
+LynxLib::E_LynxState LynxStructure::checkData(const char * data, int dataLength, const LynxInfo & lynxInfo, bool delta, bool exact) const
+{
+	int startIndex = 0;
+	int variableCount = _count;
+	int dataIndex = 0;
+
+	if (delta)
+	{
+		dataIndex = LynxLib::bitmapSize(_count);
+
+		if (dataIndex > dataLength)
+			return LynxLib::eWrongDataLength;
+	}
+	else if (lynxInfo.variableCount > 0) // Range
+	{
+		startIndex = lynxInfo.lynxId.variableIndex;
+		variableCount = lynxInfo.variableCount;
+	}
+	else if (lynxInfo.lynxId.variableIndex >= 0) // Single variable
+	{
+		startIndex = lynxInfo.lynxId.variableIndex;
+		variableCount = 1;
+	}
+
+	if ((startIndex < 0) || ((startIndex + variableCount) > _count))
+		return LynxLib::eVariableIndexOutOfBounds;
+
+	for (int i = startIndex; i < (startIndex + variableCount); i++)
+	{
+		if (delta && ((data[i / 8] & (char(1) << (i % 8))) == 0))
+			continue;
+
+		LynxLib::E_LynxDataType dataType = LynxLib::E_LynxDataType(_data[i].dataType() & 0x7f);
+
+		// Strings start with their length
+		if (dataType == LynxLib::eString_RW)
+		{
+			if (dataIndex >= dataLength)
+				return LynxLib::eWrongDataLength;
+
+			dataIndex += (int(data[dataIndex]) & 0xff) + 1;
+		}
+		else
+		{
+			dataIndex += _data[i].transferSize();
+		}
+
+		if (dataIndex > dataLength)
+			return LynxLib::eWrongDataLength;
+	}
+
+	if (exact && (dataIndex != dataLength))
+		return LynxLib::eWrongDataLength;
+
+	return LynxLib::eNewDataReceived;
+}
+
+int LynxStructure::readData(const char * data, int dataLength, LynxInfo & lynxInfo)
+{
+	if (lynxInfo.variableCount > 0) // Range
+		return this->readRange(data, dataLength, lynxInfo.lynxId.variableIndex, lynxInfo.variableCount, lynxInfo);
+	else if (lynxInfo.lynxId.variableIndex < 0) // All variables
+		return this->readRange(data, dataLength, 0, _count, lynxInfo);
+	else // Single variable
+		return this->readRange(data, dataLength, lynxInfo.lynxId.variableIndex, 1, lynxInfo);
+}
+
+int LynxStructure::readRange(const char * data, int dataLength, int startIndex, int variableCount, LynxInfo & lynxInfo, bool writeReadOnly)
+{
+	int dataIndex = 0;
+
+	lynxInfo.state = LynxLib::eNewDataReceived;
+
+	if ((startIndex < 0) || ((startIndex + variableCount) > _count)) // Invalid index
+	{
+		lynxInfo.state = LynxLib::eVariableIndexOutOfBounds;
+		return 0;
+	}
+
+	if (_frozen)
+		return this->decodePlan(data, dataLength, startIndex, variableCount, lynxInfo, writeReadOnly);
+
+	bool valueChanged = false;
+	bool * compare = (_subscriptions.count() > 0) ? &valueChanged : LYNX_NULL;
+
+	for (int i = startIndex; i < (startIndex + variableCount); i++)
+	{
+		int readSize = _data[i].fromArray(&data[dataIndex], dataLength - dataIndex, lynxInfo.state, writeReadOnly, compare);
+
+		if (valueChanged)
+			LynxLib::bitmapSet(_received, i, true);
+
+		if (readSize < 1)
+			return dataIndex;
+
+		dataIndex += readSize;
+	}
+
+	return dataIndex;
+}
+
+int LynxStructure::readDelta(const char * data, int dataLength, LynxInfo & lynxInfo)
 {
+	// The data starts with the variable bitmap, followed by the selected variables
+	int dataIndex = LynxLib::bitmapSize(_count);
+
+	lynxInfo.state = LynxLib::eNewDataReceived;
+
+	if (dataIndex > dataLength)
+	{
+		lynxInfo.state = LynxLib::eWrongDataLength;
+		return 0;
+	}
+
+	bool valueChanged = false;
+	bool * compare = (_subscriptions.count() > 0) ? &valueChanged : LYNX_NULL;
+
 	for (int i = 0; i < _count; i++)
 	{
-		if ((_data[i].structId() == structInfo.structId) || (_data[i].description() == structInfo.description))
-			return LynxDynamicId();
+		if ((data[i / 8] & (char(1) << (i % 8))) != 0)
+		{
+			int readSize = _data[i].fromArray(&data[dataIndex], dataLength - dataIndex, lynxInfo.state, false, compare);
+
+			if (valueChanged)
+				LynxLib::bitmapSet(_received, i, true);
+
+			if (readSize < 1)
+				return dataIndex;
+
+			dataIndex += readSize;
+		}
 	}
 
-	LynxDynamicId tempId;
-    tempId.structId = structInfo.structId;
-	tempId.variableIds.reserve(structInfo.variables.count());
+	return dataIndex;
+}
+
+LynxId LynxStructure::addVariable(int structIndex, LynxLib::E_LynxDataType dataType, const LynxString & description, int arrayLength)
+{
+	if (!_enableReadOnly)
+		dataType = LynxLib::E_LynxDataType(dataType & 0x7f); // Remove read only specifier
+
+	if (!validDataType(dataType) || !validArrayLength(dataType, arrayLength))
+		return LynxId();
 
-	tempId.structLynxId = this->addStructure(structInfo.structId, structInfo.description, enableReadOnly, structInfo.variables.count());
+#ifdef LYNX_MULTITHREAD
+	// The reader of latest() may still hold a pointer into the buffers, so they can't be resized
+	if (_concurrencyMode == LynxLib::eDoubleBuffer)
+		return LynxId();
+#endif // LYNX_MULTITHREAD
 
-	for (int i = 0; i < structInfo.variables.count(); i++)
+	// The variable would be added to every instance sharing the schema
+	if (!_ownsSchema)
+		return LynxId();
+
+	LynxVariableInfo variableInfo;
+	variableInfo.dataType = dataType;
+	variableInfo.description = description;
+	variableInfo.arrayLength = arrayLength;
+	normalizeVariable(variableInfo, _count, _enableReadOnly);
+
+	// Both lists may reallocate, so the variables are pointed at the schema again afterwards
+	this->append();
+	_schema->variables.append(variableInfo);
+	this->last().init(&_schema->variables.last());
+	this->bindInfos();
+	this->bindValues();
+
+	if (_changed.count() < LynxLib::bitmapSize(_count))
+		_changed.append(char(0));
+
+	if (_received.count() < LynxLib::bitmapSize(_count))
+		_received.append(char(0));
+
+	_changeStamps.append(0);
+
+	this->cacheSizes(_count - 1);
+
+	if (_frozen)
+		this->freeze();
+
+	return LynxId(structIndex, (_count - 1));
+}
+
+int LynxStructure::transferSize(int index) const
+{
+	if (index < 0) // All variables
+		return this->transferSize(0, _count);
+
+	return this->transferSize(index, 1);
+}
+
+int LynxStructure::transferSize(int startIndex, int variableCount) const
+{
+	if ((startIndex < 0) || (variableCount < 0) || ((startIndex + variableCount) > _count)) // Out of bounds
+		return 0;
+
+	if ((startIndex == 0) && (variableCount == _count)) // All variables
+	{
+		int tempSize = _fixedTransferSize;
+
+		for (int i = 0; i < _stringIndexes.count(); i++)
+		{
+			tempSize += _data[_stringIndexes.at(i)].transferSize();
+		}
+
+		return tempSize;
+	}
+
+	if (_frozen)
+	{
+		int tempSize = _offsets.at(startIndex + variableCount) - _offsets.at(startIndex);
+
+		if (_planStrings)
+		{
+			for (int i = startIndex; i < (startIndex + variableCount); i++)
+			{
+				if (_offsets.at(i) == _offsets.at(i + 1)) // Only strings have no fixed size
+					tempSize += _data[i].transferSize();
+			}
+		}
+
+		return tempSize;
+	}
+
+	int tempSize = 0;
+
+	for (int i = startIndex; i < (startIndex + variableCount); i++)
+	{
+		tempSize += _data[i].transferSize();
+	}
+
+	return tempSize;
+}
+
+int LynxStructure::transferSize(const LynxByteArray & variableMask) const
+{
+	int tempSize = 0;
+
+	for (int i = 0; i < _count; i++)
+	{
+		if (LynxLib::bitmapGet(variableMask, i))
+			tempSize += _data[i].transferSize();
+	}
+
+	return tempSize;
+}
+
+int LynxStructure::localSize(int variableIndex) const
+{
+	if (variableIndex < 0) // All variables
+	{
+		int tempSize = _fixedLocalSize;
+
+		for (int i = 0; i < _stringIndexes.count(); i++)
+		{
+			tempSize += _data[_stringIndexes.at(i)].localSize();
+		}
+
+		return tempSize;
+	}
+	else if (variableIndex >= _count) // Out of bounds
+	{
+		return 0;
+	}
+	else // Single variable
+	{
+		return _data[variableIndex].localSize();
+	}
+}
+
+LynxString LynxStructure::description() const
+{
+	if(_description == LYNX_NULL)
+		return LynxString();
+
+	return *_description;
+}
+
+void LynxStructure::setChanged(int variableIndex)
+{
+	// 0 is kept for "never sent"
+	if (++_changeStamp == 0)
+		_changeStamp = 1;
+
+	if (variableIndex < 0) // All variables
+	{
+		for (int i = 0; i < _count; i++)
+		{
+			LynxLib::bitmapSet(_changed, i, true);
+			_changeStamps[i] = _changeStamp;
+		}
+	}
+	else if (variableIndex < _count) // Single variable
+	{
+		LynxLib::bitmapSet(_changed, variableIndex, true);
+		_changeStamps[variableIndex] = _changeStamp;
+	}
+}
+
+bool LynxStructure::changedSince(uint32_t stamp, int variableIndex, int variableCount) const
+{
+	if (variableIndex < 0) // All variables
 	{
-		tempId.variableIds.append(this->addVariable(tempId.structLynxId, structInfo.variables.at(i).dataType, structInfo.variables.at(i).description));
+		variableIndex = 0;
+		variableCount = _count;
 	}
 
-	return tempId;
-}
+	if ((variableIndex + variableCount) > _count)
+		variableCount = _count - variableIndex;
+
+	if ((stamp == 0) && (variableCount > 0))
+		return true;
+
+	for (int i = variableIndex; i < (variableIndex + variableCount); i++)
+	{
+		if (int32_t(_changeStamps.at(i) - stamp) > 0)
+			return true;
+	}
+
+	return false;
+}
+
+int LynxStructure::changedSince(uint32_t stamp, LynxByteArray & mask) const
+{
+	mask.reserve(LynxLib::bitmapSize(_count));
+
+	for (int i = 0; i < LynxLib::bitmapSize(_count); i++)
+	{
+		mask.append(char(0));
+	}
+
+	int tempCount = 0;
+
+	for (int i = 0; i < _count; i++)
+	{
+		if ((stamp == 0) || (int32_t(_changeStamps.at(i) - stamp) > 0))
+		{
+			LynxLib::bitmapSet(mask, i, true);
+			tempCount++;
+		}
+	}
+
+	return tempCount;
+}
+
+bool LynxStructure::changed(int variableIndex) const
+{
+	if (variableIndex < 0) // Any variable
+	{
+		for (int i = 0; i < _changed.count(); i++)
+		{
+			if (_changed.at(i) != 0)
+				return true;
+		}
+
+		return false;
+	}
+
+	return LynxLib::bitmapGet(_changed, variableIndex);
+}
+
+void LynxStructure::clearChanged(int variableIndex)
+{
+	if (variableIndex < 0) // All variables
+	{
+		for (int i = 0; i < _changed.count(); i++)
+		{
+			_changed[i] = 0;
+		}
+	}
+	else
+	{
+		LynxLib::bitmapSet(_changed, variableIndex, false);
+	}
+}
+
+void LynxStructure::setConcurrencyMode(LynxLib::E_LynxConcurrencyMode mode)
+{
+	_concurrencyMode = mode;
+
+#ifdef LYNX_MULTITHREAD
+	if (_buffers != LYNX_NULL)
+	{
+		delete[] _buffers;
+		_buffers = LYNX_NULL;
+		_bufferCount = 0;
+	}
+
+	if (mode != LynxLib::eDoubleBuffer)
+		return;
+
+	_bufferCount = _count;
+	_buffers = new LynxUnion[3 * _bufferCount + 1];
+
+	// All three blocks start out with the current values
+	for (int i = 0; i < 3; i++)
+	{
+		this->storeValues(&_buffers[i * _bufferCount], _bufferCount);
+	}
+
+	_writeBuffer = 0;
+	_readBuffer = 1;
+	_publishedBuffer.store(2, std::memory_order_release);
+#endif // LYNX_MULTITHREAD
+}
+
+void LynxStructure::beginWrite()
+{
+#ifdef LYNX_MULTITHREAD
+	if (_concurrencyMode != LynxLib::eSeqlock)
+		return;
+
+	if (_writeNesting++ > 0)
+		return;
+
+	// An odd sequence number tells the readers that a write is in progress
+	_sequence.store(_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+#endif // LYNX_MULTITHREAD
+}
+
+void LynxStructure::endWrite()
+{
+#ifdef LYNX_MULTITHREAD
+	if (_concurrencyMode != LynxLib::eSeqlock)
+		return;
+
+	if (--_writeNesting > 0)
+		return;
+
+	_sequence.store(_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+#endif // LYNX_MULTITHREAD
+}
+
+int LynxStructure::snapshot(LynxList<LynxUnion> & values) const
+{
+#ifdef LYNX_MULTITHREAD
+	if (_concurrencyMode == LynxLib::eSeqlock)
+	{
+		int retries = 0;
+		uint32_t before;
+		uint32_t after;
+
+		while (true)
+		{
+			before = _sequence.load(std::memory_order_acquire);
+
+			if ((before & 1) == 0)
+			{
+				this->copyValues(values);
+
+				std::atomic_thread_fence(std::memory_order_acquire);
+				after = _sequence.load(std::memory_order_relaxed);
+
+				if (before == after)
+					return retries;
+			}
+
+			// The writer may have been preempted in the middle of a write, on a single core it only resumes if we yield
+			if (++retries >= LYNX_LOCK_SPIN_COUNT)
+				std::this_thread::yield();
+		}
+	}
+#endif // LYNX_MULTITHREAD
+
+	this->copyValues(values);
+	return 0;
+}
+
+const LynxUnion * LynxStructure::latest()
+{
+#ifdef LYNX_MULTITHREAD
+	if ((_concurrencyMode != LynxLib::eDoubleBuffer) || (_buffers == LYNX_NULL))
+		return LYNX_NULL;
+
+	// Bit 2 of the published index tells if the writer has published a new frame since the last exchange
+	if ((_publishedBuffer.load(std::memory_order_relaxed) & 0x4) != 0)
+		_readBuffer = _publishedBuffer.exchange(_readBuffer, std::memory_order_acq_rel) & 0x3;
+
+	return &_buffers[_readBuffer * _bufferCount];
+#else
+	return LYNX_NULL;
+#endif // LYNX_MULTITHREAD
+}
+
+void LynxStructure::lockRead() const
+{
+#ifdef LYNX_MULTITHREAD
+	if (_threadSafe)
+		_lock.lockRead();
+#endif // LYNX_MULTITHREAD
+}
+
+void LynxStructure::unlockRead() const
+{
+#ifdef LYNX_MULTITHREAD
+	if (_threadSafe)
+		_lock.unlockRead();
+#endif // LYNX_MULTITHREAD
+}
+
+void LynxStructure::lockWrite() const
+{
+#ifdef LYNX_MULTITHREAD
+	if (_threadSafe)
+		_lock.lockWrite();
+#endif // LYNX_MULTITHREAD
+}
+
+void LynxStructure::unlockWrite() const
+{
+#ifdef LYNX_MULTITHREAD
+	if (_threadSafe)
+		_lock.unlockWrite();
+#endif // LYNX_MULTITHREAD
+}
+
+void LynxStructure::publish()
+{
+#ifdef LYNX_MULTITHREAD
+	if ((_concurrencyMode != LynxLib::eDoubleBuffer) || (_buffers == LYNX_NULL))
+		return;
+
+	this->storeValues(&_buffers[_writeBuffer * _bufferCount], _bufferCount);
+
+	_writeBuffer = _publishedBuffer.exchange((_writeBuffer | 0x4), std::memory_order_acq_rel) & 0x3;
+#endif // LYNX_MULTITHREAD
+}
+
+void LynxStructure::copyValues(LynxList<LynxUnion> & values) const
+{
+	values.reserve(_count);
+
+	for (int i = 0; i < _count; i++)
+	{
+		values.append();
+	}
+
+	if (_count > 0)
+		this->storeValues(&values[0], _count);
+}
+
+void LynxStructure::storeValues(LynxUnion * block, int count) const
+{
+	if (count > _count)
+		count = _count;
+
+	// The slots of strings and arrays in the value block are always zero
+	if ((count > 0) && (_values != LYNX_NULL))
+		memcpy(block, _values, count * sizeof(LynxUnion));
+
+	if (_boundCount < 1)
+		return;
+
+	// The slots of bound values are unused, the values are in the application's own variables
+	for (int i = 0; i < count; i++)
+	{
+		if (!_data[i].bound())
+			continue;
+
+		block[i] = LynxUnion();
+		memcpy(&block[i], _data[i].value(), _data[i].localSize());
+	}
+}
+
+void LynxStructure::bindValues()
+{
+	// Value-initialized, so the slots of strings and arrays stay zero
+	LynxUnion * values = LYNX_NULL;
+
+	if (_count > 0)
+		values = new LynxUnion[_count]();
+
+	for (int i = 0; i < _count; i++)
+	{
+		if (!_data[i].bound())
+			_data[i].bindValue(&values[i]);
+	}
+
+	if (_values != LYNX_NULL)
+		delete[] _values;
+
+	_values = values;
+}
+
+bool LynxStructure::bind(int variableIndex, void * address)
+{
+	if ((variableIndex < 0) || (variableIndex >= _count))
+		return false;
+
+	LynxLib::E_LynxDataType dataType = LynxLib::E_LynxDataType(_data[variableIndex].dataType() & 0x7f);
+
+	if ((dataType == LynxLib::eString_RW) || LynxLib::isArray(dataType))
+		return false;
+
+	if (_data[variableIndex].bound())
+		_boundCount--;
+
+	_data[variableIndex].bindExternal(address);
+
+	if (_data[variableIndex].bound())
+		_boundCount++;
+	else
+		this->bindValues(); // Give the value its slot in the value block back
+
+	if (_frozen)
+		this->freeze();
+
+	return true;
+}
+
+bool LynxStructure::bind(void * base, const LynxBinding * bindings, int count)
+{
+	// Nothing is bound unless every binding is valid
+	for (int i = 0; i < count; i++)
+	{
+		int variableIndex = bindings[i].variableIndex;
+
+		if ((variableIndex < 0) || (variableIndex >= _count))
+			return false;
+		else if ((LynxLib::E_LynxDataType(_data[variableIndex].dataType() & 0x7f) == LynxLib::eString_RW) || (_data[variableIndex].arrayLength() > 0))
+			return false;
+		else if (int(bindings[i].size) != _data[variableIndex].localSize())
+			return false;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		this->bind(bindings[i].variableIndex, static_cast<char *>(base) + bindings[i].offset);
+	}
+
+	return true;
+}
+
+void LynxStructure::subscribe(const LynxId & lynxId, LynxChangeCallback callback, void * context)
+{
+	if (callback == LYNX_NULL)
+		return;
+
+	LynxSubscription subscription;
+	subscription.lynxId = lynxId;
+	subscription.callback = callback;
+	subscription.context = context;
+	_subscriptions.append(subscription);
+}
+
+void LynxStructure::unsubscribe(const LynxId & lynxId, LynxChangeCallback callback, void * context)
+{
+	for (int i = _subscriptions.count() - 1; i >= 0; i--)
+	{
+		const LynxSubscription & subscription = _subscriptions.at(i);
+
+		if ((subscription.lynxId.variableIndex == lynxId.variableIndex) && (subscription.callback == callback) && (subscription.context == context))
+			_subscriptions.remove(i);
+	}
+}
+
+void LynxStructure::notify()
+{
+	if (_subscriptions.count() < 1)
+		return;
+
+	for (int byte = 0; byte < _received.count(); byte++)
+	{
+		if (_received.at(byte) == 0)
+			continue;
+
+		for (int bit = 0; bit < 8; bit++)
+		{
+			int variableIndex = byte * 8 + bit;
+
+			if (!LynxLib::bitmapGet(_received, variableIndex))
+				continue;
+
+			LynxLib::bitmapSet(_received, variableIndex, false);
+
+			// Callbacks may unsubscribe, so the count is read on every step
+			for (int i = 0; i < _subscriptions.count(); i++)
+			{
+				LynxSubscription subscription = _subscriptions.at(i);
+
+				if ((subscription.lynxId.variableIndex >= 0) && (subscription.lynxId.variableIndex != variableIndex))
+					continue;
+
+				subscription.callback(LynxId(subscription.lynxId.structIndex, variableIndex), subscription.context);
+			}
+		}
+	}
+}
+
+void LynxStructure::freeze()
+{
+	this->clearPlan();
+
+	if (!littleEndianHost())
+		return;
+
+	_offsets.reserve(_count + 1);
+	_plan.reserve(_count);
+
+	int offset = 0;
+
+	for (int i = 0; i < _count; i++)
+	{
+		_offsets.append(offset);
+
+		LynxLib::E_LynxDataType dataType = _data[i].dataType();
+		bool readOnly = ((dataType & 0x80) != 0);
+		bool indirect = (_data[i].bound() || (_data[i].arrayLength() > 0) || LynxLib::isConverted(dataType));
+		int width = 0;
+
+		if ((dataType == LynxLib::eString_RW) || (dataType == LynxLib::eString_RO))
+			_planStrings = true;
+		else
+			width = _data[i].transferSize();
+
+		offset += width;
+
+		// Strings have a size of their own, arrays and bound values are not in the value block,
+		// and converted values are not copied as they are, so they always get a run to themselves
+		if ((width > 0) && !indirect && (_plan.count() > 0) && (_plan.last().width == width) && !_plan.last().indirect && (_plan.last().readOnly == readOnly))
+		{
+			_plan.last().count++;
+			continue;
+		}
+
+		LynxPlanRun run;
+		run.startIndex = i;
+		run.count = 1;
+		run.width = width;
+		run.readOnly = readOnly;
+		run.indirect = indirect;
+		_plan.append(run);
+	}
+
+	_offsets.append(offset);
+	_frozen = true;
+}
+
+void LynxStructure::cacheSizes(int variableIndex)
+{
+	LynxLib::E_LynxDataType dataType = _data[variableIndex].dataType();
+
+	if ((dataType == LynxLib::eString_RW) || (dataType == LynxLib::eString_RO))
+	{
+		_stringIndexes.append(variableIndex);
+		return;
+	}
+
+	_fixedTransferSize += _data[variableIndex].transferSize();
+	_fixedLocalSize += _data[variableIndex].localSize();
+}
+
+void LynxStructure::clearPlan()
+{
+	_frozen = false;
+	_planStrings = false;
+	_plan.clear();
+	_offsets.clear();
+}
+
+int LynxStructure::planRun(int variableIndex) const
+{
+	int low = 0;
+	int high = _plan.count() - 1;
+
+	while (low < high)
+	{
+		int middle = (low + high + 1) / 2;
+
+		if (_plan.at(middle).startIndex <= variableIndex)
+			low = middle;
+		else
+			high = middle - 1;
+	}
+
+	return low;
+}
+
+int LynxStructure::encodePlan(char * buffer, int startIndex, int variableCount, LynxLib::E_LynxState & state) const
+{
+	int endIndex = startIndex + variableCount;
+	int copiedSize = 0;
+
+	for (int r = this->planRun(startIndex); (r < _plan.count()) && (_plan.at(r).startIndex < endIndex); r++)
+	{
+		const LynxPlanRun & run = _plan.at(r);
+		int first = (run.startIndex > startIndex) ? run.startIndex : startIndex;
+		int count = ((run.startIndex + run.count) < endIndex ? (run.startIndex + run.count) : endIndex) - first;
+
+		if ((run.width == 0) || run.indirect)
+		{
+			copiedSize += _data[first].toArray(&buffer[copiedSize], state);
+			continue;
+		}
+
+		switch (run.width)
+		{
+		case 1:
+			encodeRun<1>(&buffer[copiedSize], &_values[first], count);
+			break;
+		case 2:
+			encodeRun<2>(&buffer[copiedSize], &_values[first], count);
+			break;
+		case 4:
+			encodeRun<4>(&buffer[copiedSize], &_values[first], count);
+			break;
+		default: // Full width values are laid out in the value block exactly like on the wire
+			memcpy(&buffer[copiedSize], &_values[first], count * run.width);
+			break;
+		}
+
+		copiedSize += count * run.width;
+	}
+
+	return copiedSize;
+}
+
+int LynxStructure::decodePlan(const char * data, int dataLength, int startIndex, int variableCount, LynxInfo & lynxInfo, bool writeReadOnly)
+{
+	int endIndex = startIndex + variableCount;
+	int dataIndex = 0;
+
+	for (int r = this->planRun(startIndex); (r < _plan.count()) && (_plan.at(r).startIndex < endIndex); r++)
+	{
+		const LynxPlanRun & run = _plan.at(r);
+		int first = (run.startIndex > startIndex) ? run.startIndex : startIndex;
+		int count = ((run.startIndex + run.count) < endIndex ? (run.startIndex + run.count) : endIndex) - first;
+
+		if ((run.width == 0) || run.indirect)
+		{
+			bool valueChanged = false;
+			int readSize = _data[first].fromArray(&data[dataIndex], dataLength - dataIndex, lynxInfo.state, writeReadOnly, &valueChanged);
+
+			if (valueChanged && (_subscriptions.count() > 0))
+				LynxLib::bitmapSet(_received, first, true);
+
+			if (readSize < 1)
+				return dataIndex;
+
+			dataIndex += readSize;
+			continue;
+		}
+
+		// Like the unfrozen decoder, read the variables that fit before reporting a short frame
+		bool complete = true;
+		if ((count * run.width) > (dataLength - dataIndex))
+		{
+			count = (dataLength - dataIndex) / run.width;
+			complete = false;
+		}
+
+		if ((!run.readOnly || writeReadOnly) && (_subscriptions.count() > 0))
+		{
+			decodeRunCompare(&data[dataIndex], &_values[first], count, run.width, _received, first);
+		}
+		else if (!run.readOnly || writeReadOnly)
+		{
+			switch (run.width)
+			{
+			case 1:
+				decodeRun<1>(&data[dataIndex], &_values[first], count);
+				break;
+			case 2:
+				decodeRun<2>(&data[dataIndex], &_values[first], count);
+				break;
+			case 4:
+				decodeRun<4>(&data[dataIndex], &_values[first], count);
+				break;
+			default:
+				memcpy(&_values[first], &data[dataIndex], count * run.width);
+				break;
+			}
+		}
+
+		dataIndex += count * run.width;
+
+		if (!complete)
+		{
+			lynxInfo.state = LynxLib::eWrongDataLength;
+			return dataIndex;
+		}
+	}
+
+	return dataIndex;
+}
+
+bool LynxStructure::copyRange(const LynxStructure & source, int sourceIndex, int targetIndex, int variableCount)
+{
+	if ((variableCount < 1) || (sourceIndex < 0) || (targetIndex < 0) ||
+		((sourceIndex + variableCount) > source._count) || ((targetIndex + variableCount) > _count))
+		return false;
+
+	bool indirect = false;
+
+	// The layouts must match (ignoring the access specifier), so the value blocks can be copied as they are
+	for (int i = 0; i < variableCount; i++)
+	{
+		LynxLib::E_LynxDataType dataType = LynxLib::E_LynxDataType(_data[targetIndex + i].dataType() & 0x7f);
+
+		if (dataType != LynxLib::E_LynxDataType(source._data[sourceIndex + i].dataType() & 0x7f))
+			return false;
+
+		if (_data[targetIndex + i].arrayLength() != source._data[sourceIndex + i].arrayLength())
+			return false;
+
+		if ((dataType == LynxLib::eString_RW) || LynxLib::isArray(dataType))
+			indirect = true;
+	}
+
+	this->beginWrite();
+
+	// Copied backwards if the target overlaps the end of the source in the same structure
+	bool backwards = ((&source == this) && (targetIndex > sourceIndex));
+
+	if ((_boundCount > 0) || (source._boundCount > 0))
+	{
+		// Some values are not in the value blocks, so they are copied one by one
+		for (int n = 0; n < variableCount; n++)
+		{
+			int i = backwards ? (variableCount - 1 - n) : n;
+			_data[targetIndex + i].setBits(source._data[sourceIndex + i].bits());
+		}
+	}
+	else
+	{
+		// memmove, since source and target can be overlapping ranges of the same structure
+		memmove(&_values[targetIndex], &source._values[sourceIndex], variableCount * sizeof(LynxUnion));
+	}
+
+	if (indirect)
+	{
+		for (int n = 0; n < variableCount; n++)
+		{
+			int i = backwards ? (variableCount - 1 - n) : n;
+			LynxType & target = _data[targetIndex + i];
+			const LynxType & other = source._data[sourceIndex + i];
+
+			if (LynxLib::E_LynxDataType(target.dataType() & 0x7f) == LynxLib::eString_RW)
+				target.var_string() = other.var_string();
+			else if (target.arrayLength() > 0)
+				memmove(target.arrayData(), other.arrayData(), target.localSize());
+		}
+	}
+
+	this->endWrite();
+	this->publish();
+
+	for (int i = targetIndex; i < (targetIndex + variableCount); i++)
+	{
+		this->setChanged(i);
+	}
+
+	return true;
+}
+
+int LynxStructure::changedCount() const
+{
+	int tempCount = 0;
+
+	for (int i = 0; i < _count; i++)
+	{
+		if (LynxLib::bitmapGet(_changed, i))
+			tempCount++;
+	}
+
+	return tempCount;
+}
+
+//-----------------------------------------------------------------------------------------------------------
+//----------------------------------------- LynxManager -----------------------------------------------------
+//-----------------------------------------------------------------------------------------------------------
+
+LynxManager::LynxManager(char deviceId, const LynxString & description, int size) : LynxList(size), _version(LYNX_VERSION)
+{ 
+	_deviceId = deviceId;
+	_description = LYNX_NULL;
+	_threadSafe = false;
+	_frozen = false;
+	_layoutVersion = 0;
+
+#ifdef LYNX_MULTITHREAD
+	_structCount.store(0, std::memory_order_relaxed);
+#endif // LYNX_MULTITHREAD
+
+#ifndef LYNX_NO_ID_TABLE
+	for (int i = 0; i < 256; i++)
+	{
+		_idTable[i] = 0;
+	}
+#endif // !LYNX_NO_ID_TABLE
+		
+	if (description.isEmpty())
+		return;
+
+	_description = new LynxString(description);
+}
+
+LynxManager::~LynxManager()
+{
+	if (_description != LYNX_NULL)
+	{
+		delete _description;
+		_description = LYNX_NULL;
+	}
+
+	// The instances never touch the shared schemas when they are destroyed, so the order doesn't matter
+	for (int i = 0; i < _instanceSets.count(); i++)
+	{
+		delete _instanceSets[i].schema;
+	}
+}
+
+void LynxManager::getInfo(LynxDeviceInfo & deviceInfo) const
+{
+	// Read once, structures may be added by another thread
+	int structCount = this->count();
+
+	deviceInfo.deviceId = _deviceId;
+	deviceInfo.structCount = structCount;
+	deviceInfo.lynxVersion = _version;
+		
+	if (_description == LYNX_NULL)
+		deviceInfo.description = "Not defined";
+	else
+		deviceInfo.description = *_description;
+
+	deviceInfo.structs.reserve(structCount);
+	for (int i = 0; i < structCount; i++)
+	{
+		LynxReadLocker locker(_data[i]);
+		deviceInfo.structs.append();
+		_data[i].getInfo(deviceInfo.structs[i]);
+	}
+}
+
+LynxDeviceInfo LynxManager::getInfo() const
+{
+	LynxDeviceInfo temp;
+	this->getInfo(temp);
+	return temp;
+}
+
+void LynxManager::lockNames(bool write) const
+{
+#ifdef LYNX_MULTITHREAD
+	if (!_threadSafe)
+		return;
+
+	if (write)
+		_nameLock.lockWrite();
+	else
+		_nameLock.lockRead();
+#else
+	(void)write;
+#endif // LYNX_MULTITHREAD
+}
+
+void LynxManager::unlockNames(bool write) const
+{
+#ifdef LYNX_MULTITHREAD
+	if (!_threadSafe)
+		return;
+
+	if (write)
+		_nameLock.unlockWrite();
+	else
+		_nameLock.unlockRead();
+#else
+	(void)write;
+#endif // LYNX_MULTITHREAD
+}
+
+void LynxManager::setThreadSafe(bool enable)
+{
+	_threadSafe = enable;
+
+#ifdef LYNX_MULTITHREAD
+	// Other threads may hold on to a structure while new ones are added, so the list must never be reallocated
+	if (enable)
+	{
+		LynxStructure * data = _data;
+		LynxList::resize(LYNX_MAX_STRUCTS);
+
+		if (_data != data)
+			this->layoutChanged();
+	}
+#endif // LYNX_MULTITHREAD
+
+	for (int i = 0; i < _count; i++)
+	{
+		_data[i].setThreadSafe(enable);
+	}
+}
+
+void LynxManager::freeze()
+{
+	_frozen = true;
+
+	for (int i = 0; i < this->count(); i++)
+	{
+		LynxWriteLocker locker(_data[i]);
+		_data[i].freeze();
+	}
+}
+
+uint32_t LynxManager::schemaHash(bool includeDescriptions) const
+{
+	LynxDeviceInfo deviceInfo;
+	this->getInfo(deviceInfo);
+	return LynxLib::schemaHash(deviceInfo, includeDescriptions);
+}
+
+char LynxManager::structId(const LynxId & lynxId) const
+{
+    if((lynxId.structIndex < 0) || (lynxId.structIndex > this->count()))
+        return LYNX_INVALID_DATAGRAM;
+
+    return _data[lynxId.structIndex].structId();
+}
+
+LynxString LynxManager::getStructName(const LynxId & lynxId)
+{
+    if ((lynxId.structIndex < 0) || (lynxId.structIndex >= this->count()))
+        return LynxString();
+
+    return _data[lynxId.structIndex].description();
+}
+
+LynxString LynxManager::getVariableName(const LynxId & lynxId)
+{
+    if ((lynxId.structIndex < 0) || (lynxId.structIndex >= this->count()))
+        return LynxString();
+
+    if ((lynxId.variableIndex < 0) || (lynxId.variableIndex >= _data[lynxId.structIndex].count()))
+        return LynxString();
+
+    return _data[lynxId.structIndex].at(lynxId.variableIndex).description();
+}
+
+LynxType & LynxManager::variable(const LynxId & lynxId)
+{
+	return (*this)[lynxId.structIndex][lynxId.variableIndex];
+}
+
+const LynxType & LynxManager::variable(const LynxId & lynxId) const
+{
+	return this->at(lynxId.structIndex).at(lynxId.variableIndex);
+}
+
+void LynxManager::copy(const LynxId & source, const LynxId & target)
+{
+	if ((source.variableIndex < 0) && (target.variableIndex < 0)) // Whole struct
+	{
+		if ((source.structIndex < 0) || (source.structIndex >= this->count()) || 
+			(target.structIndex < 0) || (target.structIndex >= this->count()))
+			return;
+
+		if (_data[source.structIndex].count() != _data[target.structIndex].count())
+			return;
+
+		this->copy(LynxId(source.structIndex, 0), LynxId(target.structIndex, 0), _data[source.structIndex].count());
+		return;
+	}
+
+	this->copy(source, target, 1);
+}
+
+void LynxManager::copy(const LynxId & source, const LynxId & target, int variableCount)
+{
+	if ((source.structIndex < 0) || (source.structIndex >= this->count()) || 
+		(target.structIndex < 0) || (target.structIndex >= this->count()))
+		return;
+
+	// Structures are locked in index order, so copies running in opposite directions can not deadlock
+	if (source.structIndex < target.structIndex)
+	{
+		LynxReadLocker sourceLocker(_data[source.structIndex]);
+		LynxWriteLocker targetLocker(_data[target.structIndex]);
+
+		_data[target.structIndex].copyRange(_data[source.structIndex], source.variableIndex, target.variableIndex, variableCount);
+	}
+	else
+	{
+		LynxWriteLocker targetLocker(_data[target.structIndex]);
+		LynxReadLocker sourceLocker(_data[source.structIndex]);
+
+		_data[target.structIndex].copyRange(_data[source.structIndex], source.variableIndex, target.variableIndex, variableCount);
+	}
+}
+
+LynxLib::E_LynxState LynxManager::toArray(LynxByteArray & buffer, const LynxId & lynxId) const
+{
+	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= this->count()))
+		return LynxLib::eStructIndexOutOfBounds;
+
+	LynxReadLocker locker(_data[lynxId.structIndex]);
+
+	int totalSize = _data[lynxId.structIndex].transferSize(lynxId.variableIndex) + LYNX_HEADER_BYTES + LYNX_CHECKSUM_BYTES;
+	int copiedSize;
+
+	// Reserving does not reallocate if the buffer is already large enough, so a reused buffer costs no allocations
+	buffer.reserve(totalSize);
+
+	LynxLib::E_LynxState state = this->toArray(buffer.extend(totalSize), totalSize, copiedSize, lynxId);
+
+	if (copiedSize < 1)
+		buffer.clear();
+
+	return state;
+}
+
+LynxLib::E_LynxState LynxManager::toArray(char * buffer, int maxSize, int & copiedSize, const LynxId & lynxId) const
+{
+	// |  Description   |    Size    |     Index    | Contents |
+	// ---------------------------------------------------------
+	// | Static header  |     1      |       0      |   'A'    |
+	// |   Struct Id    |     1      |       1      | 0 -> 254 |
+	// | Variable index |     1      |       2      | 0 -> 255 |
+	// |  Data length   |     1      |       3      | 0 -> 255 |
+	// |   Device Id    |     1      |       4      | 0 -> 255 |
+	// |     Data       | dataLength | 5 -> (n - 2) |    -     |
+	// |   Checksum     |     1      |    (n - 1)   | 0 -> 255 |
+
+	// n = 5 + dataLength + 1
+
+	copiedSize = 0;
+
+	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= this->count()))
+		return LynxLib::eStructIndexOutOfBounds;
+
+	LynxReadLocker locker(_data[lynxId.structIndex]);
+
+	int dataLength = _data[lynxId.structIndex].transferSize(lynxId.variableIndex);
+
+	if (dataLength < 1)
+		return LynxLib::eDataLengthNotFound;
+
+	if (dataLength > 0xff) // The data length is a single byte, larger data (e.g. long arrays) needs a range datagram
+		return LynxLib::eWrongDataLength;
+
+	if ((dataLength + LYNX_HEADER_BYTES + LYNX_CHECKSUM_BYTES) > maxSize)
+		return LynxLib::eBufferTooSmall;
+
+	buffer[0] = LYNX_STATIC_HEADER;
+	buffer[1] = _data[lynxId.structIndex].structId();
+	buffer[2] = static_cast<char>(lynxId.variableIndex + 1);
+	buffer[3] = static_cast<char>(dataLength);
+	buffer[4] = _deviceId;
+
+	int dataSize;
+	LynxLib::E_LynxState state = _data[lynxId.structIndex].toArray(&buffer[LYNX_HEADER_BYTES], dataLength, dataSize, lynxId.variableIndex);
+
+	if (state != LynxLib::eDataCopiedToBuffer)
+		return state;
+
+	LynxLib::addChecksum(buffer, LYNX_HEADER_BYTES + dataSize);
+	copiedSize = LYNX_HEADER_BYTES + dataSize + LYNX_CHECKSUM_BYTES;
+
+	return state;
+}
+
+LynxLib::E_LynxState LynxManager::toArray(LynxByteArray & buffer, const LynxId & lynxId, const LynxByteArray & variableMask) const
+{
+	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= this->count()))
+		return LynxLib::eStructIndexOutOfBounds;
+
+	LynxReadLocker locker(_data[lynxId.structIndex]);
+
+	int totalSize = LynxLib::bitmapSize(_data[lynxId.structIndex].count()) + _data[lynxId.structIndex].transferSize(variableMask);
+	totalSize += LYNX_DELTA_HEADER_BYTES + LYNX_CHECKSUM_BYTES;
+	int copiedSize;
+
+	buffer.reserve(totalSize);
+
+	LynxLib::E_LynxState state = this->toArray(buffer.extend(totalSize), totalSize, copiedSize, lynxId, variableMask);
+
+	if (copiedSize < 1)
+		buffer.clear();
+
+	return state;
+}
+
+LynxLib::E_LynxState LynxManager::toArray(char * buffer, int maxSize, int & copiedSize, const LynxId & lynxId, const LynxByteArray & variableMask) const
+{
+	// |  Description    |    Size    |       Index        |  Contents  |
+	// ------------------------------------------------------------------
+	// | Static header   |     1      |         0          |    'A'     |
+	// |  Datagram Id    |     1      |         1          |    255     |
+	// | Int. data id    |     1      |         2          |     7      |
+	// |   Struct Id     |     1      |         3          |  0 -> 254  |
+	// |  Data length    |     2      |       4 -> 5       | 0 -> 65535 |
+	// |   Device Id     |     1      |         6          |  0 -> 255  |
+	// | Variable bitmap |     b      |    7 -> (6 + b)    |     -      |
+	// |     Data        |     -      | (7 + b) -> (n - 2) |     -      |
+	// |   Checksum      |     1      |      (n - 1)       |  0 -> 255  |
+
+	// b = number of bytes required for one bit per variable in the struct
+	// Data length = b + size of the selected variables
+	// n = 7 + dataLength + 1
+
+	copiedSize = 0;
+
+	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= this->count()))
+		return LynxLib::eStructIndexOutOfBounds;
+
+	LynxReadLocker locker(_data[lynxId.structIndex]);
+
+	int bitmapSize = LynxLib::bitmapSize(_data[lynxId.structIndex].count());
+	int valueLength = _data[lynxId.structIndex].transferSize(variableMask);
+
+	if (valueLength < 1)
+		return LynxLib::eDataLengthNotFound;
+
+	int dataLength = bitmapSize + valueLength;
+
+	if (dataLength > 0xffff)
+		return LynxLib::eWrongDataLength;
+
+	if ((dataLength + LYNX_DELTA_HEADER_BYTES + LYNX_CHECKSUM_BYTES) > maxSize)
+		return LynxLib::eBufferTooSmall;
+
+	buffer[0] = LYNX_STATIC_HEADER;
+	buffer[1] = LYNX_INTERNALS_HEADER;
+	buffer[2] = char(LynxLib::eDeltaDatagram);
+	buffer[3] = _data[lynxId.structIndex].structId();
+	buffer[4] = char(dataLength & 0xff);
+	buffer[5] = char((dataLength >> 8) & 0xff);
+	buffer[6] = _deviceId;
+
+	for (int i = 0; i < bitmapSize; i++)
+	{
+		if (i < variableMask.count())
+			buffer[LYNX_DELTA_HEADER_BYTES + i] = variableMask.at(i);
+		else
+			buffer[LYNX_DELTA_HEADER_BYTES + i] = 0;
+	}
+
+	int dataSize;
+	LynxLib::E_LynxState state = _data[lynxId.structIndex].toArray(&buffer[LYNX_DELTA_HEADER_BYTES + bitmapSize], valueLength, dataSize, variableMask);
+
+	if (state != LynxLib::eDataCopiedToBuffer)
+		return state;
+
+	LynxLib::addChecksum(buffer, LYNX_DELTA_HEADER_BYTES + bitmapSize + dataSize);
+	copiedSize = LYNX_DELTA_HEADER_BYTES + bitmapSize + dataSize + LYNX_CHECKSUM_BYTES;
+
+	return state;
+}
+
+LynxLib::E_LynxState LynxManager::toArray(LynxByteArray & buffer, const LynxId & lynxId, int variableCount) const
+{
+	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= this->count()))
+		return LynxLib::eStructIndexOutOfBounds;
+
+	LynxReadLocker locker(_data[lynxId.structIndex]);
+
+	int totalSize = this->transferSize(lynxId, variableCount) + LYNX_RANGE_HEADER_BYTES + LYNX_CHECKSUM_BYTES;
+	int copiedSize;
+
+	buffer.reserve(totalSize);
+
+	LynxLib::E_LynxState state = this->toArray(buffer.extend(totalSize), totalSize, copiedSize, lynxId, variableCount);
+
+	if (copiedSize < 1)
+		buffer.clear();
+
+	return state;
+}
+
+LynxLib::E_LynxState LynxManager::toArray(char * buffer, int maxSize, int & copiedSize, const LynxId & lynxId, int variableCount) const
+{
+	// |  Description    |    Size    |     Index    |  Contents  |
+	// ------------------------------------------------------------
+	// | Static header   |     1      |       0      |    'A'     |
+	// |  Datagram Id    |     1      |       1      |    255     |
+	// | Int. data id    |     1      |       2      |     10     |
+	// |   Struct Id     |     1      |       3      |  0 -> 254  |
+	// |  Start index    |     1      |       4      |  0 -> 255  |
+	// | Variable count  |     1      |       5      |  1 -> 255  |
+	// |  Data length    |     2      |     6 -> 7   | 0 -> 65535 |
+	// |   Device Id     |     1      |       8      |  0 -> 255  |
+	// |     Data        | dataLength | 9 -> (n - 2) |     -      |
+	// |   Checksum      |     1      |    (n - 1)   |  0 -> 255  |
+
+	// n = 9 + dataLength + 1
+
+	copiedSize = 0;
+
+	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= this->count()))
+		return LynxLib::eStructIndexOutOfBounds;
+
+	LynxReadLocker locker(_data[lynxId.structIndex]);
+
+	if ((lynxId.variableIndex < 0) || (variableCount < 1) || (variableCount > 255) ||
+		((lynxId.variableIndex + variableCount) > _data[lynxId.structIndex].count()))
+		return LynxLib::eVariableIndexOutOfBounds;
+
+	int dataLength = this->transferSize(lynxId, variableCount);
+
+	if (dataLength > 0xffff)
+		return LynxLib::eWrongDataLength;
+
+	if ((dataLength + LYNX_RANGE_HEADER_BYTES + LYNX_CHECKSUM_BYTES) > maxSize)
+		return LynxLib::eBufferTooSmall;
+
+	buffer[0] = LYNX_STATIC_HEADER;
+	buffer[1] = LYNX_INTERNALS_HEADER;
+	buffer[2] = char(LynxLib::eRangeDatagram);
+	buffer[3] = _data[lynxId.structIndex].structId();
+	buffer[4] = char(lynxId.variableIndex);
+	buffer[5] = char(variableCount);
+	buffer[6] = char(dataLength & 0xff);
+	buffer[7] = char((dataLength >> 8) & 0xff);
+	buffer[8] = _deviceId;
+
+	int dataSize;
+	LynxLib::E_LynxState state = _data[lynxId.structIndex].toArray(&buffer[LYNX_RANGE_HEADER_BYTES], dataLength, dataSize, lynxId.variableIndex, variableCount);
+
+	if (state != LynxLib::eDataCopiedToBuffer)
+		return state;
+
+	LynxLib::addChecksum(buffer, LYNX_RANGE_HEADER_BYTES + dataSize);
+	copiedSize = LYNX_RANGE_HEADER_BYTES + dataSize + LYNX_CHECKSUM_BYTES;
+
+	return state;
+}
+
+LynxLib::E_LynxState LynxManager::toArray(LynxByteArray & buffer, const LynxViewId & lynxViewId) const
+{
+	LynxNameLocker locker(*this, false);
+
+	if ((lynxViewId.viewIndex < 0) || (lynxViewId.viewIndex >= _views.count()))
+		return LynxLib::eViewIndexOutOfBounds;
+
+	int copiedSize;
+	LynxLib::E_LynxState state = LynxLib::eBufferTooSmall;
+
+	// A string written by another thread may grow between sizing and encoding, in which case the size is taken again
+	for (int attempt = 0; (attempt < LYNX_ENCODE_ATTEMPTS) && (state == LynxLib::eBufferTooSmall); attempt++)
+	{
+		int totalSize = this->transferSize(lynxViewId) + LYNX_VIEW_HEADER_BYTES + LYNX_CHECKSUM_BYTES;
+
+		buffer.reserve(totalSize);
+
+		state = this->toArray(buffer.extend(totalSize), totalSize, copiedSize, lynxViewId);
+	}
+
+	if (copiedSize < 1)
+		buffer.clear();
+	else if (copiedSize < buffer.count()) // A string may have shrunk between sizing and encoding
+		buffer.remove(copiedSize, buffer.count() - 1);
+
+	return state;
+}
+
+LynxLib::E_LynxState LynxManager::toArray(char * buffer, int maxSize, int & copiedSize, const LynxViewId & lynxViewId) const
+{
+	// See readView() for the frame layout
+
+	copiedSize = 0;
+
+	LynxNameLocker locker(*this, false);
+
+	if ((lynxViewId.viewIndex < 0) || (lynxViewId.viewIndex >= _views.count()))
+		return LynxLib::eViewIndexOutOfBounds;
+
+	const LynxView & view = _views.at(lynxViewId.viewIndex);
+	int dataLength = this->transferSize(lynxViewId);
+
+	if (dataLength < 1)
+		return LynxLib::eDataLengthNotFound;
+	else if (dataLength > 0xffff)
+		return LynxLib::eWrongDataLength;
+
+	if ((dataLength + LYNX_VIEW_HEADER_BYTES + LYNX_CHECKSUM_BYTES) > maxSize)
+		return LynxLib::eBufferTooSmall;
+
+	buffer[0] = LYNX_STATIC_HEADER;
+	buffer[1] = LYNX_INTERNALS_HEADER;
+	buffer[2] = char(LynxLib::eViewDatagram);
+	buffer[3] = view.viewId;
+	buffer[4] = char(dataLength & 0xff);
+	buffer[5] = char((dataLength >> 8) & 0xff);
+	buffer[6] = _deviceId;
+
+	int writeIndex = LYNX_VIEW_HEADER_BYTES;
+	LynxLib::E_LynxState state = LynxLib::eDataCopiedToBuffer;
+
+	for (int i = 0; i < view.lynxIds.count(); i++)
+	{
+		const LynxId & lynxId = view.lynxIds.at(i);
+		int entrySize;
+
+		// Each entry is locked on its own, so the length written in the header is corrected below
+		LynxReadLocker locker(_data[lynxId.structIndex]);
+		state = _data[lynxId.structIndex].toArray(&buffer[writeIndex], maxSize - writeIndex - LYNX_CHECKSUM_BYTES, entrySize, lynxId.variableIndex);
+
+		if (state != LynxLib::eDataCopiedToBuffer)
+			return state;
+
+		writeIndex += entrySize;
+	}
+
+	dataLength = writeIndex - LYNX_VIEW_HEADER_BYTES;
+
+	if (dataLength > 0xffff)
+		return LynxLib::eWrongDataLength;
+
+	buffer[4] = char(dataLength & 0xff);
+	buffer[5] = char((dataLength >> 8) & 0xff);
+
+	LynxLib::addChecksum(buffer, writeIndex);
+	copiedSize = writeIndex + LYNX_CHECKSUM_BYTES;
+
+	return state;
+}
+
+void LynxManager::readView(const char * buffer, int size, LynxInfo & lynxInfo)
+{
+	// |  Description   |    Size    |     Index    |  Contents  |
+	// -----------------------------------------------------------
+	// | Static header  |     1      |       0      |    'A'     |
+	// |  Datagram Id   |     1      |       1      |    255     |
+	// | Int. data id   |     1      |       2      |     15     |
+	// |    View Id     |     1      |       3      |  0 -> 255  |
+	// |  Data length   |     2      |     4 -> 5   | 0 -> 65535 |
+	// |   Device Id    |     1      |       6      |  0 -> 255  |
+	// |     Data       | dataLength | 7 -> (n - 2) |     -      |
+	// |   Checksum     |     1      |    (n - 1)   |  0 -> 255  |
+
+	// The data holds the targets of the view back to back, in the order they were added to the view
+	// n = 7 + dataLength + 1
+
+	if (size < (LYNX_VIEW_HEADER_BYTES + LYNX_CHECKSUM_BYTES))
+	{
+		lynxInfo.state = LynxLib::eBufferTooSmall;
+		return;
+	}
+
+	// The view must not change while its targets are read
+	LynxNameLocker locker(*this, false);
+
+	lynxInfo.lynxViewId = this->findView(buffer[3]);
+	lynxInfo.lynxId = LynxId();
+	lynxInfo.dataLength = (int(buffer[4]) & 0xff) | ((int(buffer[5]) << 8) & 0xff00);
+	lynxInfo.deviceId = buffer[6];
+
+	if (lynxInfo.lynxViewId.viewIndex < 0)
+	{
+		lynxInfo.state = LynxLib::eViewIdNotFound;
+		return;
+	}
+
+	int totalSize = lynxInfo.dataLength + LYNX_VIEW_HEADER_BYTES + LYNX_CHECKSUM_BYTES;
+	if (size < totalSize)
+	{
+		lynxInfo.state = LynxLib::eBufferTooSmall;
+		return;
+	}
+
+	if (!LynxLib::checkChecksum(buffer, totalSize))
+	{
+		lynxInfo.state = LynxLib::eWrongChecksum;
+		return;
+	}
+
+	const LynxView & view = _views.at(lynxInfo.lynxViewId.viewIndex);
+	int dataEnd = LYNX_VIEW_HEADER_BYTES + lynxInfo.dataLength;
+	int readIndex = LYNX_VIEW_HEADER_BYTES;
+
+	lynxInfo.state = LynxLib::eNewDataReceived;
+
+	for (int i = 0; i < view.lynxIds.count(); i++)
+	{
+		LynxInfo entryInfo;
+		entryInfo.lynxId = view.lynxIds.at(i);
+
+		LynxWriteLocker locker(_data[entryInfo.lynxId.structIndex]);
+		readIndex += _data[entryInfo.lynxId.structIndex].fromData(&buffer[readIndex], dataEnd - readIndex, entryInfo);
+
+		if (entryInfo.state >= LynxLib::eErrors)
+		{
+			lynxInfo.state = entryInfo.state;
+			return;
+		}
+	}
+
+	// The view on the remote side must have the same size
+	if (readIndex != dataEnd)
+		lynxInfo.state = LynxLib::eWrongDataLength;
+}
+
+LynxLib::E_LynxState LynxManager::toArray(LynxByteArray & buffer, const LynxList<LynxId> & lynxIds) const
+{
+	int copiedSize;
+	LynxLib::E_LynxState state = LynxLib::eBufferTooSmall;
+
+	// A string written by another thread may grow between sizing and encoding, in which case the size is taken again
+	for (int attempt = 0; (attempt < LYNX_ENCODE_ATTEMPTS) && (state == LynxLib::eBufferTooSmall); attempt++)
+	{
+		int totalSize = this->batchSize(lynxIds);
+
+		if (totalSize < 0)
+			totalSize = 0;
+
+		buffer.reserve(totalSize);
+
+		state = this->toArray(buffer.extend(totalSize), totalSize, copiedSize, lynxIds);
+	}
+
+	if (copiedSize < 1)
+		buffer.clear();
+	else if (copiedSize < buffer.count()) // A string may have shrunk between sizing and encoding
+		buffer.remove(copiedSize, buffer.count() - 1);
+
+	return state;
+}
+
+LynxLib::E_LynxState LynxManager::toArray(char * buffer, int maxSize, int & copiedSize, const LynxList<LynxId> & lynxIds) const
+{
+	// See readBatch() for the frame layout
+
+	copiedSize = 0;
+
+	if (lynxIds.count() < 1)
+		return LynxLib::eDataLengthNotFound;
+
+	for (int i = 0; i < lynxIds.count(); i++)
+	{
+		if ((lynxIds.at(i).structIndex < 0) || (lynxIds.at(i).structIndex >= this->count()))
+			return LynxLib::eStructIndexOutOfBounds;
+		else if (lynxIds.at(i).variableIndex >= _data[lynxIds.at(i).structIndex].count())
+			return LynxLib::eVariableIndexOutOfBounds;
+		else if (this->transferSize(lynxIds.at(i)) > 255) // The entry length is a single byte
+			return LynxLib::eWrongDataLength;
+	}
+
+	int totalSize = this->batchSize(lynxIds);
+
+	if (totalSize < 0)
+		return LynxLib::eDataLengthNotFound;
+
+	int dataLength = totalSize - LYNX_BATCH_HEADER_BYTES - LYNX_CHECKSUM_BYTES;
+
+	if (dataLength > 0xffff)
+		return LynxLib::eWrongDataLength;
+
+	if (totalSize > maxSize)
+		return LynxLib::eBufferTooSmall;
+
+	buffer[0] = LYNX_STATIC_HEADER;
+	buffer[1] = LYNX_INTERNALS_HEADER;
+	buffer[2] = char(LynxLib::eBatchDatagram);
+	buffer[3] = char(dataLength & 0xff);
+	buffer[4] = char((dataLength >> 8) & 0xff);
+	buffer[5] = _deviceId;
+
+	int writeIndex = LYNX_BATCH_HEADER_BYTES;
+	LynxLib::E_LynxState state = LynxLib::eDataCopiedToBuffer;
+
+	for (int i = 0; i < lynxIds.count(); i++)
+	{
+		const LynxStructure & structure = _data[lynxIds.at(i).structIndex];
+		int entrySize;
+
+		if ((writeIndex + LYNX_BATCH_ENTRY_BYTES + LYNX_CHECKSUM_BYTES) > maxSize)
+			return LynxLib::eBufferTooSmall;
+
+		buffer[writeIndex] = structure.structId();
+		buffer[writeIndex + 1] = static_cast<char>(lynxIds.at(i).variableIndex + 1);
+		writeIndex += LYNX_BATCH_ENTRY_BYTES;
+
+		// Each entry is locked on its own, so the lengths are written after the entry is encoded
+		LynxReadLocker locker(structure);
+		state = structure.toArray(&buffer[writeIndex], maxSize - writeIndex - LYNX_CHECKSUM_BYTES, entrySize, lynxIds.at(i).variableIndex);
+
+		if (state != LynxLib::eDataCopiedToBuffer)
+			return state;
+		else if (entrySize > 255)
+			return LynxLib::eWrongDataLength;
+
+		buffer[writeIndex - 1] = static_cast<char>(entrySize);
+		writeIndex += entrySize;
+	}
+
+	dataLength = writeIndex - LYNX_BATCH_HEADER_BYTES;
+
+	if (dataLength > 0xffff)
+		return LynxLib::eWrongDataLength;
+
+	buffer[3] = char(dataLength & 0xff);
+	buffer[4] = char((dataLength >> 8) & 0xff);
+
+	LynxLib::addChecksum(buffer, writeIndex);
+	copiedSize = writeIndex + LYNX_CHECKSUM_BYTES;
+
+	return state;
+}
+
+void LynxManager::fromArray(const LynxByteArray & buffer, LynxInfo & lynxInfo, LynxList<LynxId> * batchContents)
+{
+	this->fromArray(buffer.data(), buffer.count(), lynxInfo, batchContents);
+}
+
+void LynxManager::fromArray(const char * buffer, int size, LynxInfo & lynxInfo, LynxList<LynxId> * batchContents)
+{
+	int headerBytes = LYNX_HEADER_BYTES;
+
+	lynxInfo.variableCount = 0;
+	lynxInfo.lynxViewId = LynxViewId();
+
+	if (size < (LYNX_HEADER_BYTES + LYNX_CHECKSUM_BYTES))
+	{
+		lynxInfo.state = LynxLib::eBufferTooSmall;
+		return;
+	}
+
+	if ((buffer[1] == LYNX_INTERNALS_HEADER) && (LynxLib::E_LynxInternals(int(buffer[2]) & 0xff) == LynxLib::eViewDatagram))
+	{
+		this->readView(buffer, size, lynxInfo);
+		return;
+	}
+
+	if ((buffer[1] == LYNX_INTERNALS_HEADER) && (LynxLib::E_LynxInternals(int(buffer[2]) & 0xff) == LynxLib::eBatchDatagram))
+	{
+		this->readBatch(buffer, size, lynxInfo, batchContents);
+		return;
+	}
+
+	if ((buffer[1] == LYNX_INTERNALS_HEADER) && (LynxLib::E_LynxInternals(int(buffer[2]) & 0xff) == LynxLib::eRangeDatagram))
+	{
+		if (size < (LYNX_RANGE_HEADER_BYTES + LYNX_CHECKSUM_BYTES))
+		{
+			lynxInfo.state = LynxLib::eBufferTooSmall;
+			return;
+		}
+
+		lynxInfo.lynxId.structIndex = this->findId(buffer[3]);
+		lynxInfo.lynxId.variableIndex = int(buffer[4]) & 0xff;
+		lynxInfo.variableCount = int(buffer[5]) & 0xff;
+		lynxInfo.dataLength = (int(buffer[6]) & 0xff) | ((int(buffer[7]) << 8) & 0xff00);
+		lynxInfo.deviceId = buffer[8];
+		headerBytes = LYNX_RANGE_HEADER_BYTES;
+	}
+	else if (buffer[1] == LYNX_INTERNALS_HEADER) // Delta datagram
+	{
+		if (size < (LYNX_DELTA_HEADER_BYTES + LYNX_CHECKSUM_BYTES))
+		{
+			lynxInfo.state = LynxLib::eBufferTooSmall;
+			return;
+		}
+
+		if (LynxLib::E_LynxInternals(int(buffer[2]) & 0xff) != LynxLib::eDeltaDatagram)
+		{
+			lynxInfo.state = LynxLib::eInvalidInternalId;
+			return;
+		}
+
+		lynxInfo.lynxId.structIndex = this->findId(buffer[3]);
+		lynxInfo.lynxId.variableIndex = -1;
+		lynxInfo.dataLength = (int(buffer[4]) & 0xff) | ((int(buffer[5]) << 8) & 0xff00);
+		lynxInfo.deviceId = buffer[6];
+		headerBytes = LYNX_DELTA_HEADER_BYTES;
+	}
+	else
+	{
+		lynxInfo.lynxId.structIndex = this->findId(buffer[1]);
+		lynxInfo.lynxId.variableIndex = (int(buffer[2]) & 0xff) - 1;
+		lynxInfo.dataLength = int(buffer[3]) & 0xff;
+		lynxInfo.deviceId = buffer[4];
+	}
+
+	// Check the struct ID
+	if (lynxInfo.lynxId.structIndex < 0)
+	{
+		lynxInfo.state = LynxLib::eStructIdNotFound;
+		return;
+	}
+
+	// Variables may be added to the struct by another thread
+	LynxWriteLocker locker(_data[lynxInfo.lynxId.structIndex]);
+
+	// Check the variable index
+	if ((headerBytes == LYNX_RANGE_HEADER_BYTES) && 
+		((lynxInfo.variableCount < 1) || ((lynxInfo.lynxId.variableIndex + lynxInfo.variableCount) > _data[lynxInfo.lynxId.structIndex].count())))
+	{
+		lynxInfo.state = LynxLib::eVariableIndexOutOfBounds;
+		return;
+	}
+	else if (lynxInfo.lynxId.variableIndex >= _data[lynxInfo.lynxId.structIndex].count())
+	{
+		lynxInfo.state = LynxLib::eVariableIndexOutOfBounds;
+		return;
+	}
+
+	// Check the total size
+	int totalSize = lynxInfo.dataLength + headerBytes + LYNX_CHECKSUM_BYTES;
+	if (size < totalSize)
+	{
+		lynxInfo.state = LynxLib::eBufferTooSmall;
+		return;
+	}
+
+	// Check the checksum
+	if (!LynxLib::checkChecksum(buffer, totalSize))
+	{
+		lynxInfo.state = LynxLib::eWrongChecksum;
+		return;
+	}
+
+	// Copy the data
+	_data[lynxInfo.lynxId.structIndex].fromArray(buffer, totalSize, lynxInfo);
+}
+
+void LynxManager::readBatch(const char * buffer, int size, LynxInfo & lynxInfo, LynxList<LynxId> * batchContents)
+{
+	// |  Description   |    Size    |     Index    |  Contents  |
+	// -----------------------------------------------------------
+	// | Static header  |     1      |       0      |    'A'     |
+	// |  Datagram Id   |     1      |       1      |    255     |
+	// | Int. data id   |     1      |       2      |     8      |
+	// |  Data length   |     2      |     3 -> 4   | 0 -> 65535 |
+	// |   Device Id    |     1      |       5      |  0 -> 255  |
+	// |    Entries     | dataLength | 6 -> (n - 2) |     -      |
+	// |   Checksum     |     1      |    (n - 1)   |  0 -> 255  |
+
+	// Each entry has the same layout as a regular datagram without the static header, device id and checksum:
+	// |   Struct Id    |     1      |       0      |  0 -> 254  |
+	// | Variable index |     1      |       1      |  0 -> 255  |
+	// | Entry length   |     1      |       2      |  0 -> 255  |
+	// |     Data       |    len     |   3 -> ...   |     -      |
+
+	// n = 6 + dataLength + 1
+
+	if (batchContents)
+		batchContents->clear();
+
+	if (size < (LYNX_BATCH_HEADER_BYTES + LYNX_CHECKSUM_BYTES))
+	{
+		lynxInfo.state = LynxLib::eBufferTooSmall;
+		return;
+	}
+
+	lynxInfo.dataLength = (int(buffer[3]) & 0xff) | ((int(buffer[4]) << 8) & 0xff00);
+	lynxInfo.deviceId = buffer[5];
+
+	int totalSize = lynxInfo.dataLength + LYNX_BATCH_HEADER_BYTES + LYNX_CHECKSUM_BYTES;
+	if (size < totalSize)
+	{
+		lynxInfo.state = LynxLib::eBufferTooSmall;
+		return;
+	}
+
+	if (!LynxLib::checkChecksum(buffer, totalSize))
+	{
+		lynxInfo.state = LynxLib::eWrongChecksum;
+		return;
+	}
+
+	int dataEnd = LYNX_BATCH_HEADER_BYTES + lynxInfo.dataLength;
+	int readIndex = LYNX_BATCH_HEADER_BYTES;
+
+	lynxInfo.state = LynxLib::eNewDataReceived;
+
+	while (readIndex < dataEnd)
+	{
+		if ((readIndex + LYNX_BATCH_ENTRY_BYTES) > dataEnd)
+		{
+			lynxInfo.state = LynxLib::eWrongDataLength;
+			return;
+		}
+
+		LynxInfo entryInfo;
+		entryInfo.deviceId = lynxInfo.deviceId;
+		entryInfo.structId = buffer[readIndex];
+		entryInfo.lynxId.structIndex = this->findId(buffer[readIndex]);
+		entryInfo.lynxId.variableIndex = (int(buffer[readIndex + 1]) & 0xff) - 1;
+		entryInfo.dataLength = int(buffer[readIndex + 2]) & 0xff;
+
+		readIndex += LYNX_BATCH_ENTRY_BYTES;
+
+		if ((readIndex + entryInfo.dataLength) > dataEnd)
+		{
+			lynxInfo.state = LynxLib::eWrongDataLength;
+			return;
+		}
+
+		// Entries for unknown structs are skipped, so the rest of the batch is still received
+		if (entryInfo.lynxId.structIndex >= 0)
+		{
+			LynxWriteLocker locker(_data[entryInfo.lynxId.structIndex]);
+
+			if (entryInfo.lynxId.variableIndex < _data[entryInfo.lynxId.structIndex].count())
+			{
+				_data[entryInfo.lynxId.structIndex].fromData(&buffer[readIndex], entryInfo.dataLength, entryInfo);
+
+				if (entryInfo.state >= LynxLib::eErrors)
+				{
+					lynxInfo.state = entryInfo.state;
+					return;
+				}
+
+				lynxInfo.structId = entryInfo.structId;
+				lynxInfo.lynxId = entryInfo.lynxId;
+
+				if (batchContents)
+					batchContents->append(entryInfo.lynxId);
+			}
+		}
+
+		readIndex += entryInfo.dataLength;
+	}
+}
+
+int LynxManager::batchSize(const LynxList<LynxId> & lynxIds) const
+{
+	int totalSize = LYNX_BATCH_HEADER_BYTES + LYNX_CHECKSUM_BYTES;
+
+	for (int i = 0; i < lynxIds.count(); i++)
+	{
+		if ((lynxIds.at(i).structIndex < 0) || (lynxIds.at(i).structIndex >= this->count()))
+			return -1;
+
+		int entryLength = this->transferSize(lynxIds.at(i));
+
+		if (entryLength < 1)
+			return -1;
+
+		totalSize += LYNX_BATCH_ENTRY_BYTES + entryLength;
+	}
+
+	return totalSize;
+}
+
+int LynxManager::transferSize(const LynxId & lynxId) const
+{
+	LynxReadLocker locker(_data[lynxId.structIndex]);
+	return _data[lynxId.structIndex].transferSize(lynxId.variableIndex);
+}
+
+int LynxManager::transferSize(const LynxId & lynxId, int variableCount) const
+{
+	LynxReadLocker locker(_data[lynxId.structIndex]);
+	return _data[lynxId.structIndex].transferSize(lynxId.variableIndex, variableCount);
+}
+
+int LynxManager::transferSize(const LynxViewId & lynxViewId) const
+{
+	LynxNameLocker locker(*this, false);
+
+	const LynxView & view = _views.at(lynxViewId.viewIndex);
+
+	if (view.transferSize >= 0)
+		return view.transferSize;
+
+	int tempSize = 0;
+
+	for (int i = 0; i < view.lynxIds.count(); i++)
+	{
+		tempSize += this->transferSize(view.lynxIds.at(i));
+	}
+
+	return tempSize;
+}
+
+int LynxManager::transferSize(const LynxId & lynxId, const LynxByteArray & variableMask) const
+{
+	LynxReadLocker locker(_data[lynxId.structIndex]);
+	return _data[lynxId.structIndex].transferSize(variableMask);
+}
+
+int LynxManager::localSize(const LynxId & lynxId) const
+{
+	LynxReadLocker locker(_data[lynxId.structIndex]);
+	return _data[lynxId.structIndex].localSize(lynxId.variableIndex);
+}
+
+LynxId LynxManager::addStructure(char structId, const LynxString & description, bool enableReadOnly, int size)
+{
+	if (!this->canAddStructure(structId, description))
+		return LynxId();
+
+	this->newStructure().init(structId, &description, enableReadOnly, size);
+
+	return LynxId(this->publishStructure());
+}
+
+LynxDynamicId LynxManager::addStructure(const LynxStructInfo & structInfo, bool enableReadOnly)
+{
+	if (!this->canAddStructure(structInfo.structId, structInfo.description))
+		return LynxDynamicId();
+
+	// All the variables are added before the structure is published, so other threads never see it grow
+	if (!this->newStructure().init(structInfo, enableReadOnly))
+		return LynxDynamicId();
+
+	LynxDynamicId tempId;
+	tempId.structId = structInfo.structId;
+	tempId.structLynxId = LynxId(this->publishStructure());
+	tempId.variableIds.reserve(structInfo.variables.count());
+
+	for (int i = 0; i < structInfo.variables.count(); i++)
+	{
+		tempId.variableIds.append(LynxId(tempId.structLynxId.structIndex, i));
+	}
+
+	return tempId;
+}
+
+LynxId LynxManager::addInstances(const LynxStructInfo & schema, char firstStructId, int count, bool enableReadOnly)
+{
+	if (count < 1)
+		return LynxId();
+
+	// Check everything first, so either all instances are added or none
+	for (int i = 0; i < schema.variables.count(); i++)
+	{
+		LynxLib::E_LynxDataType dataType = schema.variables.at(i).dataType;
+
+		if (!enableReadOnly)
+			dataType = LynxLib::E_LynxDataType(dataType & 0x7f);
+
+		if (!validDataType(dataType) || !validArrayLength(dataType, schema.variables.at(i).arrayLength) || !validScaling(schema.variables.at(i)))
+			return LynxId();
+	}
+
+	LynxList<LynxString> descriptions;
+	descriptions.reserve(count);
+
+	for (int i = 0; i < count; i++)
+	{
+		int structId = (int(firstStructId) & 0xff) + i;
+
+		if ((structId < 1) || (structId >= (int(LYNX_INTERNALS_HEADER) & 0xff)))
+			return LynxId();
+
+		LynxString description(schema.description);
+		description += LynxString::number(int32_t(i));
+		descriptions.append(description);
+
+		if (!this->canAddStructure(char(structId), description))
+			return LynxId();
+	}
+
+	// One copy of the schema is kept for the variables of all instances, and outlives them
+	LynxStructInfo * shared = new LynxStructInfo(schema);
+	shared->variableCount = shared->variables.count();
+
+	for (int i = 0; i < shared->variables.count(); i++)
+	{
+		normalizeVariable(shared->variables[i], i, enableReadOnly);
+	}
+
+	LynxInstanceSet instanceSet;
+	instanceSet.schema = shared;
+	instanceSet.count = count;
+
+	for (int i = 0; i < count; i++)
+	{
+		this->newStructure().init(char((int(firstStructId) & 0xff) + i), descriptions.at(i), *shared, enableReadOnly);
+
+		int structIndex = this->publishStructure();
+
+		if (i == 0)
+			instanceSet.firstIndex = structIndex;
+	}
+
+	_instanceSets.append(instanceSet);
+
+	return LynxId(instanceSet.firstIndex);
+}
+
+LynxId LynxManager::instance(const LynxId & firstInstance, int n, int variableIndex) const
+{
+	for (int i = 0; i < _instanceSets.count(); i++)
+	{
+		const LynxInstanceSet & instanceSet = _instanceSets.at(i);
+
+		if (instanceSet.firstIndex != firstInstance.structIndex)
+			continue;
+
+		if ((n < 0) || (n >= instanceSet.count) || (variableIndex >= instanceSet.schema->variables.count()))
+			return LynxId();
+
+		return LynxId(instanceSet.firstIndex + n, variableIndex);
+	}
+
+	return LynxId();
+}
+
+void LynxManager::layoutChanged()
+{
+#ifdef LYNX_MULTITHREAD
+	// Published after the values have moved, for the acquire in layoutVersion()
+	_layoutVersion.fetch_add(1, std::memory_order_release);
+#else
+	_layoutVersion++;
+#endif // LYNX_MULTITHREAD
+}
+
+bool LynxManager::canAddStructure(char structId, const LynxString & description) const
+{
+	if (this->findId(structId) >= 0)
+		return false;
+
+	if (this->findStructure(description).structIndex >= 0)
+		return false;
+
+#ifndef LYNX_NO_ID_TABLE
+	if (_count >= 255) // The table can't hold more structs than there are struct ids
+		return false;
+#endif // !LYNX_NO_ID_TABLE
+
+	return true;
+}
+
+LynxStructure & LynxManager::newStructure()
+{
+	int capacity = _count + 1;
+
+#ifdef LYNX_MULTITHREAD
+	// In thread safe mode the list is allocated once (see setThreadSafe())
+	if (_threadSafe && (capacity < LYNX_MAX_STRUCTS))
+		capacity = LYNX_MAX_STRUCTS;
+#endif // LYNX_MULTITHREAD
+
+	LynxStructure * data = _data;
+
+	LynxList::resize(capacity);
+
+	// Growing the list moves the values of every structure
+	if (_data != data)
+		this->layoutChanged();
+
+	return _data[_count];
+}
+
+int LynxManager::publishStructure()
+{
+	int structIndex = _count;
+	_count++;
+
+	_data[structIndex].setThreadSafe(_threadSafe);
+
+	if (_frozen)
+		_data[structIndex].freeze();
+
+	LynxNameLocker locker(*this, true);
+
+	_structNames.insert(_data[structIndex].description().hash(), LynxId(structIndex));
+
+	for (int i = 0; i < _data[structIndex].count(); i++)
+	{
+		_variableNames.insert(_data[structIndex].at(i).description().hash(), LynxId(structIndex, i));
+	}
+
+#ifdef LYNX_MULTITHREAD
+	// A thread that sees the new count also sees everything written to the structure above
+	_structCount.store(_count, std::memory_order_release);
+#endif // LYNX_MULTITHREAD
+
+#ifndef LYNX_NO_ID_TABLE
+	_idTable[int(_data[structIndex].structId()) & 0xff] = uint8_t(structIndex + 1);
+#endif // !LYNX_NO_ID_TABLE
+
+	return structIndex;
+}
+
+LynxId LynxManager::addVariable(const LynxId & parentStruct, LynxLib::E_LynxDataType dataType, const LynxString & description, int arrayLength)
+{
+	if ((parentStruct.structIndex < 0) || (parentStruct.structIndex >= this->count()))
+		return (LynxId());
+
+	// Name lookups read the descriptions of the variables, which move together with the values
+	LynxNameLocker nameLocker(*this, true);
+	LynxId temp;
+
+	{
+		// The values of the structure move, so readers and writers on other threads must wait
+		LynxWriteLocker locker(_data[parentStruct.structIndex]);
+
+		temp = _data[parentStruct.structIndex].addVariable(parentStruct.structIndex, dataType, description, arrayLength);
+
+		if (temp.variableIndex >= 0)
+			this->layoutChanged();
+	}
+
+	if (temp.variableIndex >= 0)
+		_variableNames.insert(this->variable(temp).description().hash(), temp);
+
+	// Views that contain the whole struct have changed size
+	for (int i = 0; i < _views.count(); i++)
+	{
+		this->updateViewSize(_views[i]);
+	}
+
+	return temp;
+}
+
+LynxId LynxManager::addArray(const LynxId & parentStruct, LynxLib::E_LynxDataType dataType, int arrayLength, const LynxString & description)
+{
+	if (!LynxLib::isArray(dataType))
+		return LynxId();
+
+	return this->addVariable(parentStruct, dataType, description, arrayLength);
+}
+
+LynxViewId LynxManager::addView(char viewId, const LynxList<LynxId> & lynxIds, const LynxString & name)
+{
+	LynxNameLocker locker(*this, true);
+
+	for (int i = 0; i < lynxIds.count(); i++)
+	{
+		if ((lynxIds.at(i).structIndex < 0) || (lynxIds.at(i).structIndex >= this->count()))
+			return LynxViewId();
+		else if (lynxIds.at(i).variableIndex >= _data[lynxIds.at(i).structIndex].count())
+			return LynxViewId();
+	}
+
+	LynxViewId temp = this->findView(viewId);
+
+	if (temp.viewIndex < 0)
+		temp.viewIndex = _views.append();
+
+	LynxView & view = _views[temp.viewIndex];
+
+	view.viewId = viewId;
+	view.name = name;
+	view.lynxIds = lynxIds;
+
+	this->updateViewSize(view);
+
+	return temp;
+}
+
+LynxViewId LynxManager::findView(char viewId) const
+{
+	LynxNameLocker locker(*this, false);
+
+	for (int i = 0; i < _views.count(); i++)
+	{
+		if (_views.at(i).viewId == viewId)
+			return LynxViewId(i);
+	}
+
+	return LynxViewId();
+}
+
+LynxViewId LynxManager::findView(const LynxString & name) const
+{
+	LynxNameLocker locker(*this, false);
+
+	for (int i = 0; i < _views.count(); i++)
+	{
+		if (_views.at(i).name.compare(name))
+			return LynxViewId(i);
+	}
+
+	return LynxViewId();
+}
+
+void LynxManager::updateViewSize(LynxView & view) const
+{
+	view.transferSize = 0;
+
+	for (int i = 0; i < view.lynxIds.count(); i++)
+	{
+		const LynxId & lynxId = view.lynxIds.at(i);
+
+		if (lynxId.variableIndex < 0) // Whole struct
+		{
+			for (int j = 0; j < _data[lynxId.structIndex].count(); j++)
+			{
+				if (LynxLib::transferSize(_data[lynxId.structIndex].at(j).dataType()) < 1) // Variable size
+				{
+					view.transferSize = -1;
+					return;
+				}
+			}
+		}
+		else if (LynxLib::transferSize(this->dataType(lynxId)) < 1)
+		{
+			view.transferSize = -1;
+			return;
+		}
+
+		view.transferSize += this->transferSize(lynxId);
+	}
+}
+
+// ------------------------- Snapshot --------------------------
+// -------------------------------------------------------------
+// |    Description   |    Size    |     Index    |  Contents  |
+// -------------------------------------------------------------
+// |       Magic      |     4      |    0 -> 3    |   "LYNS"   |
+// |  Format version  |     1      |       4      |     2      |
+// |   Schema length  |     4      |    5 -> 8    |     -      |
+// |      Schema      |     a      | 9 -> (A - 1) |     -      |
+// |   Values length  |     4      |  A -> A + 3  |     -      |
+// |      Values      |     b      |  (A + 4) ->  |     -      |
+// |     Checksum     |     1      |    (n - 1)   |  0 -> 255  |
+// -------------------------------------------------------------
+// a = Schema length (same layout as the device data of an eDeviceInfo datagram)
+// A = 9 + a
+// b = Values length (the data of a regular datagram with all variables, for each struct in order,
+//     except that eHalf and eScaled16 are stored as 4 byte floats)
+
+static const char lynxSnapshotMagic[4] = { 'L', 'Y', 'N', 'S' };
+
+static int32_t readSnapshotInt(const char * buffer)
+{
+	int32_t value = 0;
+
+	for (int i = 0; i < 4; i++)
+	{
+		value |= ((int32_t(buffer[i]) & 0xff) << (8 * i));
+	}
+
+	return value;
+}
+
+LynxLib::E_LynxState LynxManager::saveSnapshot(LynxByteArray & buffer) const
+{
+	LynxDeviceInfo deviceInfo;
+	this->getInfo(deviceInfo);
+
+	int schemaLength = LynxLib::deviceInfoSize(deviceInfo);
+	int valueLength = 0;
+
+	// Only the structures in the schema above are saved, even if more are added meanwhile
+	for (int i = 0; i < deviceInfo.structs.count(); i++)
+	{
+		LynxReadLocker locker(_data[i]);
+		valueLength += _data[i].snapshotSize();
+	}
+
+	buffer.reserve(LYNX_SNAPSHOT_HEADER_BYTES + schemaLength + 4 + valueLength + LYNX_CHECKSUM_BYTES);
+
+	buffer.append(lynxSnapshotMagic, 4);
+	buffer.append(LYNX_SNAPSHOT_VERSION);
+	LynxLib::expandInt(int32_t(schemaLength), buffer);
+	LynxLib::deviceInfoToArray(deviceInfo, buffer);
+
+	int valueIndex = buffer.count();
+	LynxLib::expandInt(int32_t(valueLength), buffer);
+
+	for (int i = 0; i < deviceInfo.structs.count(); i++)
+	{
+		LynxReadLocker locker(_data[i]);
+
+		if (_data[i].count() < 1)
+			continue;
+
+		LynxLib::E_LynxState state = _data[i].toSnapshot(buffer);
+
+		if (state >= LynxLib::eErrors)
+		{
+			buffer.clear();
+			return state;
+		}
+	}
+
+	// Strings may have changed size since the length was calculated, if other threads are writing
+	valueLength = buffer.count() - valueIndex - 4;
+
+	for (int i = 0; i < 4; i++)
+	{
+		buffer[valueIndex + i] = char((valueLength >> (8 * i)) & 0xff);
+	}
+
+	LynxLib::addChecksum(buffer);
+
+	return LynxLib::eDataCopiedToBuffer;
+}
+
+LynxLib::E_LynxState LynxManager::loadSnapshot(const char * buffer, int size)
+{
+	if (size < (LYNX_SNAPSHOT_HEADER_BYTES + 4 + LYNX_CHECKSUM_BYTES))
+		return LynxLib::eWrongDataLength;
+
+	if ((memcmp(buffer, lynxSnapshotMagic, 4) != 0) || (buffer[4] != LYNX_SNAPSHOT_VERSION))
+		return LynxLib::eWrongStaticHeader;
+
+	int schemaLength = readSnapshotInt(&buffer[5]);
+	int valueIndex = LYNX_SNAPSHOT_HEADER_BYTES + schemaLength;
+
+	if ((schemaLength < 0) || ((valueIndex + 4 + LYNX_CHECKSUM_BYTES) > size))
+		return LynxLib::eWrongDataLength;
+
+	int valueLength = readSnapshotInt(&buffer[valueIndex]);
+	valueIndex += 4;
+
+	if ((valueLength < 0) || ((valueIndex + valueLength + LYNX_CHECKSUM_BYTES) != size))
+		return LynxLib::eWrongDataLength;
+
+	if (!LynxLib::checkChecksum(buffer, size))
+		return LynxLib::eWrongChecksum;
+
+	LynxDeviceInfo deviceInfo;
+
+	if (LynxLib::deviceInfoFromArray(&buffer[LYNX_SNAPSHOT_HEADER_BYTES], schemaLength, deviceInfo) != schemaLength)
+		return LynxLib::eWrongDataLength;
+
+	// Built aside, so a snapshot that fails to load leaves the current structures untouched
+	LynxManager loaded(deviceInfo.deviceId, deviceInfo.description);
+	loaded._threadSafe = _threadSafe;
+	loaded._frozen = _frozen;
+
+	LynxLib::E_LynxState state = loaded.readSnapshot(deviceInfo, &buffer[valueIndex], valueLength);
+
+	if (state >= LynxLib::eErrors)
+		return state;
+
+	this->takeStructures(loaded);
+
+	return LynxLib::eNewDataReceived;
+}
+
+LynxLib::E_LynxState LynxManager::readSnapshot(const LynxDeviceInfo & deviceInfo, const char * values, int valueLength)
+{
+	// All the structures are allocated at once, instead of growing the list for every addStructure()
+	int capacity = deviceInfo.structs.count();
+
+#ifdef LYNX_MULTITHREAD
+	if (_threadSafe && (capacity < LYNX_MAX_STRUCTS))
+		capacity = LYNX_MAX_STRUCTS;
+#endif // LYNX_MULTITHREAD
+
+	LynxList::reserve(capacity);
+
+	for (int i = 0; i < deviceInfo.structs.count(); i++)
+	{
+		const LynxStructInfo & structInfo = deviceInfo.structs.at(i);
+
+		// Read only variables can only be in the snapshot if the struct allowed them
+		bool enableReadOnly = false;
+		for (int j = 0; j < structInfo.variables.count(); j++)
+		{
+			if (LynxLib::accessMode(structInfo.variables.at(j).dataType) == LynxLib::eReadOnly)
+				enableReadOnly = true;
+		}
+
+		if (!this->canAddStructure(structInfo.structId, structInfo.description))
+			return LynxLib::eInvalidStructId;
+
+		if (!this->newStructure().init(structInfo, enableReadOnly))
+			return LynxLib::eDataTypeNotFound;
+
+		this->publishStructure();
+	}
+
+	// Values
+	LynxInfo lynxInfo;
+	int dataIndex = 0;
+
+	for (int i = 0; i < _count; i++)
+	{
+		if (_data[i].count() < 1)
+			continue;
+
+		lynxInfo.lynxId = LynxId(i, -1);
+
+		dataIndex += _data[i].fromSnapshot(&values[dataIndex], valueLength - dataIndex, lynxInfo);
+
+		if (lynxInfo.state >= LynxLib::eErrors)
+			return lynxInfo.state;
+	}
+
+	if (dataIndex != valueLength)
+		return LynxLib::eWrongDataLength;
+
+	return LynxLib::eNewDataReceived;
+}
+
+void LynxManager::takeStructures(LynxManager & other)
+{
+	// The structures are handed over as they are, so they don't move in memory
+	LynxStructure * data = _data;
+	_data = other._data;
+	other._data = data;
+
+	int count = _count;
+	_count = other._count;
+	other._count = count;
+
+	int reservedCount = _reservedCount;
+	_reservedCount = other._reservedCount;
+	other._reservedCount = reservedCount;
+
+	this->layoutChanged();
+
+#ifdef LYNX_MULTITHREAD
+	_structCount.store(_count, std::memory_order_release);
+	other._structCount.store(other._count, std::memory_order_release);
+#endif // LYNX_MULTITHREAD
+
+#ifndef LYNX_NO_ID_TABLE
+	for (int i = 0; i < 256; i++)
+	{
+		uint8_t index = _idTable[i];
+		_idTable[i] = uint8_t(other._idTable[i]);
+		other._idTable[i] = index;
+	}
+#endif // !LYNX_NO_ID_TABLE
+
+	_deviceId = other._deviceId;
+
+	LynxString * description = _description;
+	_description = other._description;
+	other._description = description;
+
+	LynxNameLocker locker(*this, true);
+
+	_structNames = other._structNames;
+	_variableNames = other._variableNames;
+
+	// Views refer to the old structures
+	_views.clear();
 
-LynxId LynxManager::addVariable(const LynxId & parentStruct, LynxLib::E_LynxDataType dataType, const LynxString & description)
-{
-        if ((parentStruct.structIndex < 0) || (parentStruct.structIndex > _count))
-        return (LynxId());
-		 	
-        return _data[parentStruct.structIndex].addVariable(parentStruct.structIndex, dataType, description);
+	// The old shared schemas are deleted together with the old structures
+	LynxList<LynxInstanceSet> instanceSets = _instanceSets;
+	_instanceSets = other._instanceSets;
+	other._instanceSets = instanceSets;
 }
 
 LynxLib::E_LynxDataType LynxManager::dataType(const LynxId & lynxId) const
 {
-	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= _count))
+	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= this->count()))
 		return LynxLib::eNotInitialized;
 	else if ((lynxId.variableIndex < 0) || (lynxId.variableIndex >= _data[lynxId.structIndex].count()))
 		return LynxLib::eNotInitialized;
@@ -1117,7 +4749,7 @@ LynxLib::E_LynxDataType LynxManager::dataType(const LynxId & lynxId) const
 
 LynxLib::E_LynxSimplifiedType LynxManager::simplifiedType(const LynxId & lynxId) const
 {
-    if ((lynxId.structIndex < 0) || (lynxId.structIndex >= _count))
+    if ((lynxId.structIndex < 0) || (lynxId.structIndex >= this->count()))
         return LynxLib::eNotInit;
     else if ((lynxId.variableIndex < 0) || (lynxId.variableIndex >= _data[lynxId.structIndex].count()))
         return LynxLib::eNotInit;
@@ -1128,6 +4760,8 @@ LynxLib::E_LynxSimplifiedType LynxManager::simplifiedType(const LynxId & lynxId)
         return LynxLib::eString;
     else if (tempType == LynxLib::eBoolean_RW)
         return LynxLib::eBool;
+    else if (LynxLib::isArray(tempType))
+        return LynxLib::eArray;
     else if ((tempType > LynxLib::eNotInitialized) && (tempType < LynxLib::eLynxType_RW_EndOfList))
         return LynxLib::eNumber;
 
@@ -1136,7 +4770,7 @@ LynxLib::E_LynxSimplifiedType LynxManager::simplifiedType(const LynxId & lynxId)
 
 bool LynxManager::outOfBounds(const LynxId & lynxId) const
 {
-	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= _count))
+	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= this->count()))
 		return true;
 	
 	if ((lynxId.variableIndex < 0) || (lynxId.variableIndex >= _data[lynxId.structIndex].count()))
@@ -1151,9 +4785,15 @@ void LynxManager::setValue(double value, const LynxId & lynxId)
 	if (this->outOfBounds(lynxId))
 		return;
 
+	LynxWriteLocker locker(_data[lynxId.structIndex]);
+
 	// Remove the access specifier (bit 7)
 	LynxLib::E_LynxDataType dataType = LynxLib::E_LynxDataType(this->dataType(lynxId) & 0x7f);
 
+	uint64_t previous = this->variable(lynxId).bits();
+
+	_data[lynxId.structIndex].beginWrite();
+
 	switch (dataType)
 	{
 	case LynxLib::eInt8_RW:
@@ -1181,6 +4821,8 @@ void LynxManager::setValue(double value, const LynxId & lynxId)
 		this->variable(lynxId).var_u64() = uint64_t(value);
 		break;
 	case LynxLib::eFloat_RW:
+	case LynxLib::eHalf_RW:
+	case LynxLib::eScaled16_RW:
 		this->variable(lynxId).var_float() = float(value);
 		break;
 	case LynxLib::eDouble_RW:
@@ -1192,6 +4834,11 @@ void LynxManager::setValue(double value, const LynxId & lynxId)
 	default:
 		break;
 	}
+
+	_data[lynxId.structIndex].endWrite();
+
+	if (this->variable(lynxId).bits() != previous)
+		_data[lynxId.structIndex].setChanged(lynxId.variableIndex);
 }
 
 double LynxManager::getValue(const LynxId & lynxId) const
@@ -1200,6 +4847,8 @@ double LynxManager::getValue(const LynxId & lynxId) const
 	if (this->outOfBounds(lynxId))
 		return 0.0;
 
+	LynxReadLocker locker(_data[lynxId.structIndex]);
+
 	// Remove the access specifier (bit 7)
 	LynxLib::E_LynxDataType dataType = LynxLib::E_LynxDataType(this->dataType(lynxId) & 0x7f);
 
@@ -1222,6 +4871,8 @@ double LynxManager::getValue(const LynxId & lynxId) const
 	case LynxLib::eUint64_RW:
 		return double(this->variable(lynxId).var_u64());
 	case LynxLib::eFloat_RW:
+	case LynxLib::eHalf_RW:
+	case LynxLib::eScaled16_RW:
 		return double(this->variable(lynxId).var_float());
 	case LynxLib::eDouble_RW:
 		return this->variable(lynxId).var_double();
@@ -1240,12 +4891,21 @@ void LynxManager::setString(const LynxString & str, const LynxId & lynxId)
 	if (this->outOfBounds(lynxId))
 		return;
 
+	LynxWriteLocker locker(_data[lynxId.structIndex]);
+
 	// Remove the access specifier (bit 7)
 	LynxLib::E_LynxDataType dataType = LynxLib::E_LynxDataType(this->dataType(lynxId) & 0x7f);
 
 	if (dataType == LynxLib::eString_RW) 
 	{
+		if (this->variable(lynxId).var_string() == str)
+			return;
+
+		_data[lynxId.structIndex].beginWrite();
 		this->variable(lynxId).var_string() = str;
+		_data[lynxId.structIndex].endWrite();
+
+		_data[lynxId.structIndex].setChanged(lynxId.variableIndex);
 	}
 }
 
@@ -1255,6 +4915,8 @@ LynxString LynxManager::getString(const LynxId & lynxId) const
 	if (this->outOfBounds(lynxId))
 		return LynxString();
 
+	LynxReadLocker locker(_data[lynxId.structIndex]);
+
 	// Remove the access specifier (bit 7)
 	LynxLib::E_LynxDataType dataType = LynxLib::E_LynxDataType(this->dataType(lynxId) & 0x7f);
 
@@ -1270,13 +4932,22 @@ void LynxManager::setBool(bool value, const LynxId & lynxId)
 	if (this->outOfBounds(lynxId))
 		return;
 
+	LynxWriteLocker locker(_data[lynxId.structIndex]);
+
 	// Remove the access specifier (bit 7)
 	LynxLib::E_LynxDataType dataType = LynxLib::E_LynxDataType(this->dataType(lynxId) & 0x7f);
 
 	if (dataType != LynxLib::eBoolean_RW)
 		return;
 
+	if (this->variable(lynxId).var_bool() == value)
+		return;
+
+	_data[lynxId.structIndex].beginWrite();
 	this->variable(lynxId).var_bool() = value;
+	_data[lynxId.structIndex].endWrite();
+
+	_data[lynxId.structIndex].setChanged(lynxId.variableIndex);
 }
 
 bool LynxManager::getBool(const LynxId & lynxId) const
@@ -1285,6 +4956,8 @@ bool LynxManager::getBool(const LynxId & lynxId) const
 	if (this->outOfBounds(lynxId))
 		return false;
 
+	LynxReadLocker locker(_data[lynxId.structIndex]);
+
 	// Remove the access specifier (bit 7)
 	LynxLib::E_LynxDataType dataType = LynxLib::E_LynxDataType(this->dataType(lynxId) & 0x7f);
 
@@ -1300,22 +4973,29 @@ void LynxManager::setBit(int bit, bool value, const LynxId & lynxId)
 	if (this->outOfBounds(lynxId))
 		return;
 
+	LynxWriteLocker locker(_data[lynxId.structIndex]);
+
 	// Remove the access specifier (bit 7)
 	LynxLib::E_LynxDataType dataType = LynxLib::E_LynxDataType(this->dataType(lynxId) & 0x7f);
 
 	if (dataType == LynxLib::eString_RW)
 		return;
 
-	int64_t & temp = this->variable(lynxId).var_i64();
+	// Bits beyond the size of the data type are dropped
+	LynxType & variable = this->variable(lynxId);
+	uint64_t previous = variable.bits();
+
+	_data[lynxId.structIndex].beginWrite();
 
 	if (value)
-	{
-		temp |= (int64_t(1) << bit);
-	}
+		variable.setBits(previous | (uint64_t(1) << bit));
 	else
-	{
-		temp &= ~(int64_t(1) << bit);
-	}
+		variable.setBits(previous & ~(uint64_t(1) << bit));
+
+	_data[lynxId.structIndex].endWrite();
+
+	if (variable.bits() != previous)
+		_data[lynxId.structIndex].setChanged(lynxId.variableIndex);
 }
 
 bool LynxManager::getBit(int bit, const LynxId & lynxId) const
@@ -1324,49 +5004,428 @@ bool LynxManager::getBit(int bit, const LynxId & lynxId) const
 	if (this->outOfBounds(lynxId))
 		return false;
 
+	LynxReadLocker locker(_data[lynxId.structIndex]);
+
 	// Remove the access specifier (bit 7)
 	LynxLib::E_LynxDataType dataType = LynxLib::E_LynxDataType(this->dataType(lynxId) & 0x7f);
 
 	if (dataType == LynxLib::eString_RW)
 		return false;
 
-	return (this->variable(lynxId).var_i64() & (int64_t(1) << bit));
+	return ((this->variable(lynxId).bits() & (uint64_t(1) << bit)) != 0);
+}
+
+int LynxManager::arrayLength(const LynxId & lynxId) const
+{
+	if (this->outOfBounds(lynxId))
+		return 0;
+
+	return this->variable(lynxId).arrayLength();
+}
+
+int LynxManager::setArray(const void * values, const LynxId & lynxId, int firstElement, int count)
+{
+	// Check for "Out of bounds"
+	if (this->outOfBounds(lynxId))
+		return 0;
+
+	LynxWriteLocker locker(_data[lynxId.structIndex]);
+
+	LynxType & variable = this->variable(lynxId);
+
+	if ((firstElement < 0) || (count < 1) || (firstElement >= variable.arrayLength()))
+		return 0;
+
+	if (count > (variable.arrayLength() - firstElement))
+		count = variable.arrayLength() - firstElement;
+
+	int width = LynxLib::localSize(variable.dataType());
+	char * elements = static_cast<char *>(variable.arrayData()) + firstElement * width;
+
+	if (memcmp(elements, values, count * width) == 0)
+		return count;
+
+	_data[lynxId.structIndex].beginWrite();
+	memcpy(elements, values, count * width);
+	_data[lynxId.structIndex].endWrite();
+
+	_data[lynxId.structIndex].setChanged(lynxId.variableIndex);
+
+	return count;
+}
+
+int LynxManager::getArray(void * values, const LynxId & lynxId, int firstElement, int count) const
+{
+	// Check for "Out of bounds"
+	if (this->outOfBounds(lynxId))
+		return 0;
+
+	LynxReadLocker locker(_data[lynxId.structIndex]);
+
+	const LynxType & variable = this->variable(lynxId);
+
+	if ((firstElement < 0) || (count < 1) || (firstElement >= variable.arrayLength()))
+		return 0;
+
+	if (count > (variable.arrayLength() - firstElement))
+		count = variable.arrayLength() - firstElement;
+
+	int width = LynxLib::localSize(variable.dataType());
+	memcpy(values, static_cast<const char *>(variable.arrayData()) + firstElement * width, count * width);
+
+	return count;
+}
+
+void LynxManager::setElement(double value, const LynxId & lynxId, int element)
+{
+	LynxUnion temp;
+
+	switch (LynxLib::E_LynxDataType(LynxLib::elementType(this->dataType(lynxId)) & 0x7f))
+	{
+	case LynxLib::eInt8_RW:
+		temp._var_i8 = int8_t(value);
+		break;
+	case LynxLib::eUint8_RW:
+		temp._var_u8 = uint8_t(value);
+		break;
+	case LynxLib::eInt16_RW:
+		temp._var_i16 = int16_t(value);
+		break;
+	case LynxLib::eUint16_RW:
+		temp._var_u16 = uint16_t(value);
+		break;
+	case LynxLib::eInt32_RW:
+		temp._var_i32 = int32_t(value);
+		break;
+	case LynxLib::eUint32_RW:
+		temp._var_u32 = uint32_t(value);
+		break;
+	case LynxLib::eInt64_RW:
+		temp._var_i64 = int64_t(value);
+		break;
+	case LynxLib::eUint64_RW:
+		temp._var_u64 = uint64_t(value);
+		break;
+	case LynxLib::eFloat_RW:
+		temp._var_float = float(value);
+		break;
+	case LynxLib::eDouble_RW:
+		temp._var_double = value;
+		break;
+	default:
+		return;
+	}
+
+	// Not an array, or out of bounds, if nothing is copied
+	this->setArray(&temp, lynxId, element, 1);
+}
+
+double LynxManager::getElement(const LynxId & lynxId, int element) const
+{
+	LynxUnion temp;
+
+	if (this->getArray(&temp, lynxId, element, 1) < 1)
+		return 0.0;
+
+	switch (LynxLib::E_LynxDataType(LynxLib::elementType(this->dataType(lynxId)) & 0x7f))
+	{
+	case LynxLib::eInt8_RW:
+		return double(temp._var_i8);
+	case LynxLib::eUint8_RW:
+		return double(temp._var_u8);
+	case LynxLib::eInt16_RW:
+		return double(temp._var_i16);
+	case LynxLib::eUint16_RW:
+		return double(temp._var_u16);
+	case LynxLib::eInt32_RW:
+		return double(temp._var_i32);
+	case LynxLib::eUint32_RW:
+		return double(temp._var_u32);
+	case LynxLib::eInt64_RW:
+		return double(temp._var_i64);
+	case LynxLib::eUint64_RW:
+		return double(temp._var_u64);
+	case LynxLib::eFloat_RW:
+		return double(temp._var_float);
+	case LynxLib::eDouble_RW:
+		return temp._var_double;
+	default:
+		break;
+	}
+
+	return 0.0;
+}
+
+bool LynxManager::setScaling(const LynxId & lynxId, float scale, float offset)
+{
+	if (this->outOfBounds(lynxId))
+		return false;
+
+	LynxWriteLocker locker(_data[lynxId.structIndex]);
+
+	return this->variable(lynxId).setScaling(scale, offset);
 }
 
 int LynxManager::structVariableCount(int structIndex)
 {
-	if ((structIndex < 0) || (structIndex >= _count))
+	if ((structIndex < 0) || (structIndex >= this->count()))
 		return 0;
 
 	return _data[structIndex].count();
 }
 
-int LynxManager::findId(char structId)
+void LynxManager::setChanged(const LynxId & lynxId)
 {
-	for (int i = 0; i < _count; i++)
+	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= this->count()))
+		return;
+
+	LynxWriteLocker locker(_data[lynxId.structIndex]);
+
+	_data[lynxId.structIndex].setChanged(lynxId.variableIndex);
+}
+
+bool LynxManager::changed(const LynxId & lynxId) const
+{
+	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= this->count()))
+		return false;
+
+	LynxReadLocker locker(_data[lynxId.structIndex]);
+
+	return _data[lynxId.structIndex].changed(lynxId.variableIndex);
+}
+
+void LynxManager::clearChanged(const LynxId & lynxId)
+{
+	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= this->count()))
+		return;
+
+	LynxWriteLocker locker(_data[lynxId.structIndex]);
+
+	_data[lynxId.structIndex].clearChanged(lynxId.variableIndex);
+}
+
+int LynxManager::changedCount(const LynxId & lynxId) const
+{
+	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= this->count()))
+		return 0;
+
+	LynxReadLocker locker(_data[lynxId.structIndex]);
+
+	return _data[lynxId.structIndex].changedCount();
+}
+
+const LynxByteArray & LynxManager::changedMask(const LynxId & lynxId) const
+{
+	return _data[lynxId.structIndex].changedMask();
+}
+
+uint32_t LynxManager::changeStamp(const LynxId & lynxId) const
+{
+	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= this->count()))
+		return 0;
+
+	LynxReadLocker locker(_data[lynxId.structIndex]);
+
+	return _data[lynxId.structIndex].changeStamp();
+}
+
+bool LynxManager::changedSince(const LynxId & lynxId, uint32_t stamp, int variableCount) const
+{
+	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= this->count()))
+		return false;
+
+	LynxReadLocker locker(_data[lynxId.structIndex]);
+
+	return _data[lynxId.structIndex].changedSince(stamp, lynxId.variableIndex, variableCount);
+}
+
+int LynxManager::changedSince(const LynxId & lynxId, uint32_t stamp, LynxByteArray & mask) const
+{
+	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= this->count()))
+		return 0;
+
+	LynxReadLocker locker(_data[lynxId.structIndex]);
+
+	return _data[lynxId.structIndex].changedSince(stamp, mask);
+}
+
+bool LynxManager::bind(const LynxId & lynxId, void * address)
+{
+	if (this->outOfBounds(lynxId))
+		return false;
+
+	LynxWriteLocker locker(_data[lynxId.structIndex]);
+
+	if (!_data[lynxId.structIndex].bind(lynxId.variableIndex, address))
+		return false;
+
+	this->layoutChanged();
+
+	return true;
+}
+
+bool LynxManager::bind(const LynxId & lynxId, void * base, const LynxBinding * bindings, int count)
+{
+	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= this->count()))
+		return false;
+
+	LynxWriteLocker locker(_data[lynxId.structIndex]);
+
+	if (!_data[lynxId.structIndex].bind(base, bindings, count))
+		return false;
+
+	this->layoutChanged();
+
+	return true;
+}
+
+bool LynxManager::subscribe(const LynxId & lynxId, LynxChangeCallback callback, void * context)
+{
+	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= this->count()))
+		return false;
+	else if (lynxId.variableIndex >= _data[lynxId.structIndex].count())
+		return false;
+
+	LynxWriteLocker locker(_data[lynxId.structIndex]);
+	_data[lynxId.structIndex].subscribe(lynxId, callback, context);
+
+	return true;
+}
+
+void LynxManager::unsubscribe(const LynxId & lynxId, LynxChangeCallback callback, void * context)
+{
+	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= this->count()))
+		return;
+
+	LynxWriteLocker locker(_data[lynxId.structIndex]);
+	_data[lynxId.structIndex].unsubscribe(lynxId, callback, context);
+}
+
+void LynxManager::setConcurrencyMode(const LynxId & lynxId, LynxLib::E_LynxConcurrencyMode mode)
+{
+	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= this->count()))
+		return;
+
+	_data[lynxId.structIndex].setConcurrencyMode(mode);
+}
+
+const LynxUnion * LynxManager::latest(const LynxId & lynxId)
+{
+	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= this->count()))
+		return LYNX_NULL;
+
+	return _data[lynxId.structIndex].latest();
+}
+
+int LynxManager::snapshot(const LynxId & lynxId, LynxList<LynxUnion> & values) const
+{
+	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= this->count()))
+	{
+		values.clear();
+		return 0;
+	}
+
+	return _data[lynxId.structIndex].snapshot(values);
+}
+
+void LynxManager::beginWrite(const LynxId & lynxId)
+{
+	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= this->count()))
+		return;
+
+	_data[lynxId.structIndex].beginWrite();
+}
+
+void LynxManager::endWrite(const LynxId & lynxId)
+{
+	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= this->count()))
+		return;
+
+	_data[lynxId.structIndex].endWrite();
+}
+
+int LynxManager::findId(char structId) const
+{
+#ifndef LYNX_NO_ID_TABLE
+	return (int(_idTable[int(structId) & 0xff]) - 1);
+#else
+	for (int i = 0; i < this->count(); i++)
 	{
 		if (_data[i].structId() == structId)
 			return i;
 	}
 
 	return -1;
+#endif // !LYNX_NO_ID_TABLE
 }
 
-bool LynxVar::getBit(int bit) const
+LynxId LynxManager::findStructure(const LynxString & description) const
 {
-	return (_lynxManager->variable(_lynxId).var_i64() & (int64_t(1) << bit));
+	LynxNameLocker locker(*this, false);
+
+	for (int entry = _structNames.first(description.hash()); entry >= 0; entry = _structNames.next(entry))
+	{
+		const LynxId & temp = _structNames.lynxId(entry);
+
+		if (_data[temp.structIndex].description().compare(description))
+			return temp;
+	}
+
+	return LynxId();
 }
 
-void LynxVar::setBit(int bit, bool value)
+LynxId LynxManager::findVariable(const LynxString & description) const
 {
-	int64_t & temp = _lynxManager->variable(_lynxId).var_i64();
+	LynxNameLocker locker(*this, false);
 
-	if (value)
+	for (int entry = _variableNames.first(description.hash()); entry >= 0; entry = _variableNames.next(entry))
 	{
-		temp |= (int64_t(1) << bit);
+		const LynxId & temp = _variableNames.lynxId(entry);
+
+		if (this->variable(temp).description().compare(description))
+			return temp;
 	}
-	else
+
+	return LynxId();
+}
+
+LynxId LynxManager::findVariable(const LynxString & description, const LynxId & parentStruct) const
+{
+	LynxNameLocker locker(*this, false);
+
+	for (int entry = _variableNames.first(description.hash()); entry >= 0; entry = _variableNames.next(entry))
 	{
-		temp &= ~(int64_t(1) << bit);
+		const LynxId & temp = _variableNames.lynxId(entry);
+
+		if (temp.structIndex != parentStruct.structIndex)
+			continue;
+
+		if (this->variable(temp).description().compare(description))
+			return temp;
 	}
+
+	return LynxId();
+}
+
+bool LynxVar::getBit(int bit) const
+{
+	return ((_lynxManager->variable(_lynxId).bits() & (uint64_t(1) << bit)) != 0);
+}
+
+void LynxVar::setBit(int bit, bool value)
+{
+	LynxType & variable = _lynxManager->variable(_lynxId);
+	uint64_t previous = variable.bits();
+
+	_lynxManager->beginWrite(_lynxId);
+
+	if (value)
+		variable.setBits(previous | (uint64_t(1) << bit));
+	else
+		variable.setBits(previous & ~(uint64_t(1) << bit));
+
+	_lynxManager->endWrite(_lynxId);
+
+	if (variable.bits() != previous)
+		_lynxManager->setChanged(_lynxId);
 }
@@ -14,6 +14,14 @@
 #include <stdint.h>
 #endif // TI
 
+#include <stddef.h>
+
+// Define LYNX_MULTITHREAD to enable the concurrency modes and the thread safe mode of LynxStructure (requires <atomic> and <thread>)
+#ifdef LYNX_MULTITHREAD
+#include <atomic>
+#include <thread>
+#endif // LYNX_MULTITHREAD
+
 #ifndef LYNX_NULL
 #ifdef TI
 #define LYNX_NULL 0
@@ -24,9 +32,24 @@
 
 #define SIZE_64 sizeof(int64_t) // The local size of a 64 bit integer
 
+// Define LYNX_NO_ID_TABLE to save the 256 byte struct id lookup table in LynxManager on targets with very little RAM.
+// LynxManager::findId() will then fall back to a linear search.
+
 #define LYNX_STATIC_HEADER 'A'	// Static header for Lynx datagrams (always the first byte of a datagram)
 #define LYNX_HEADER_BYTES 5		// Number of header bytes
 #define LYNX_CHECKSUM_BYTES 1	// Number of checksum bytes
+#define LYNX_DELTA_HEADER_BYTES 7	// Number of header bytes in a delta datagram
+#define LYNX_BATCH_HEADER_BYTES 6	// Number of header bytes in a batch datagram
+#define LYNX_BATCH_ENTRY_BYTES 3	// Number of header bytes for each entry in a batch datagram
+#define LYNX_RANGE_HEADER_BYTES 9	// Number of header bytes in a range datagram
+#define LYNX_VIEW_HEADER_BYTES 7	// Number of header bytes in a view datagram
+
+#define LYNX_SNAPSHOT_HEADER_BYTES 9	// Number of header bytes in a manager snapshot
+#define LYNX_SNAPSHOT_VERSION char(2)	// Format version of manager snapshots
+
+#define LYNX_MAX_STRUCTS 256	// One structure per struct id
+
+#define LYNX_ENCODE_ATTEMPTS 3	// Times a multi-struct datagram is sized and encoded before giving up, if strings keep growing
 
 #define LYNX_INTERNALS_HEADER char(255)
 #define LYNX_INVALID_DATAGRAM char(0)
@@ -86,6 +109,19 @@ namespace LynxLib
 		eStartPeriodic,
 		eStopPeriodic,
         eChangeDeviceId,
+		eDeltaDatagram,
+		eBatchDatagram,
+		eCapabilities,
+		eRangeDatagram,
+		ePullRange,
+		eStartPeriodicRange,
+		eStopPeriodicRange,
+		eDefineView,
+		eViewDatagram,
+		ePullView,
+		eStartPeriodicView,
+		eStopPeriodicView,
+		eSchemaHash,
 		eLynxInternals_EndOfList
 	};
 
@@ -102,6 +138,9 @@ namespace LynxLib
 		ePeriodicTransmitStart,
 		ePeriodicTransmitStop,
         eDeviceIdUpdated,
+		eCapabilitiesReceived,
+		eViewDefined,
+		eSchemaHashReceived,
 		// Anything above eError is an error
 		eErrors,
 		eOutOfSync,
@@ -122,6 +161,8 @@ namespace LynxLib
 		eInvalidInternalId,
 		eDataTypeNotFound,
         eInvalidDeviceId,
+		eViewIdNotFound,
+		eViewIndexOutOfBounds,
 		eLynxState_EndOfList
 	};
 
@@ -140,6 +181,18 @@ namespace LynxLib
 		eDouble_RW,
 		eString_RW,
 		eBoolean_RW,
+		eInt8Array_RW,		// Arrays have a fixed number of elements, given when the variable is added
+		eUint8Array_RW,
+		eInt16Array_RW,
+		eUint16Array_RW,
+		eInt32Array_RW,
+		eUint32Array_RW,
+		eInt64Array_RW,
+		eUint64Array_RW,
+		eFloatArray_RW,
+		eDoubleArray_RW,
+		eHalf_RW,			// Local float, sent as an IEEE 754 half precision float (2 bytes)
+		eScaled16_RW,		// Local float, sent as a signed 16 bit integer: value = raw * scale + offset (see LynxType::setScaling())
 		eLynxType_RW_EndOfList,
 		eLynxType_RO_StartOfList = 0x80,
 		eInt8_RO,
@@ -154,6 +207,18 @@ namespace LynxLib
 		eDouble_RO,
 		eString_RO,
 		eBoolean_RO,
+		eInt8Array_RO,
+		eUint8Array_RO,
+		eInt16Array_RO,
+		eUint16Array_RO,
+		eInt32Array_RO,
+		eUint32Array_RO,
+		eInt64Array_RO,
+		eUint64Array_RO,
+		eFloatArray_RO,
+		eDoubleArray_RO,
+		eHalf_RO,
+		eScaled16_RO,
 		eLynxType_RO_EndOfList
 	};
 
@@ -162,7 +227,8 @@ namespace LynxLib
         eNotInit = 0,
         eNumber,
         eString,
-        eBool
+        eBool,
+        eArray
     };
 	
 	enum E_LynxAccessMode
@@ -178,22 +244,65 @@ namespace LynxLib
 		eLittleEndian
 	};
 
+	enum E_LynxConcurrencyMode
+	{
+		eNoConcurrency = 0,	// No synchronization, the structure must only be used from one thread
+		eSeqlock,			// Writes bump a sequence counter so readers can take consistent snapshots without locking
+		eDoubleBuffer		// Every completely decoded frame is published to a single reader thread with one atomic swap
+	};
+
 	int splitArray(LynxByteArray & buffer, int desiredSize);
 
 	int mergeArray(LynxByteArray & buffer, int desiredSize);
 
 	char sizeMask(int shiftSize);
 
+	// For array types these are the sizes of one element
 	int localSize(LynxLib::E_LynxDataType dataType);
 
 	int transferSize(LynxLib::E_LynxDataType dataType);
 
+	bool isArray(E_LynxDataType dataType);
+	// The type of one element of an array type, with the same access specifier (other types are returned as they are)
+	E_LynxDataType elementType(E_LynxDataType dataType);
+	// The array type with elements of dataType, or eNotInitialized if there is none
+	E_LynxDataType arrayType(E_LynxDataType dataType);
+
+	// True for the data types that have a different representation on the wire than locally (eHalf and eScaled16)
+	bool isConverted(E_LynxDataType dataType);
+
+	// IEEE 754 half precision conversion, rounded to nearest even. Values out of range become infinity.
+	uint16_t floatToHalf(float value);
+	float halfToFloat(uint16_t half);
+
 	bool checkChecksum(const LynxByteArray & buffer);
+	// Checks the checksum of a complete datagram of size bytes (checksum last)
+	bool checkChecksum(const char * buffer, int size);
 	void addChecksum(LynxByteArray & buffer);
+	// Writes the checksum of the first size bytes to buffer[size]
+	void addChecksum(char * buffer, int size);
 
 	void expandInt(int32_t input, LynxByteArray & buffer);
 	int32_t combineInt(const LynxByteArray & buffer, int startIndex);
 
+	// Returns the number of bytes required to hold a bitmap with bitCount bits
+	int bitmapSize(int bitCount);
+	bool bitmapGet(const LynxByteArray & bitmap, int index);
+	void bitmapSet(LynxByteArray & bitmap, int index, bool value);
+
+	// Returns the number of bytes needed to encode deviceInfo with deviceInfoToArray()
+	int deviceInfoSize(const LynxDeviceInfo & deviceInfo);
+	// Appends the device data block of an eDeviceInfo datagram to buffer
+	void deviceInfoToArray(const LynxDeviceInfo & deviceInfo, LynxByteArray & buffer);
+	// Decodes a device data block. Returns the number of bytes read, or -1 if the block is truncated.
+	int deviceInfoFromArray(const char * buffer, int size, LynxDeviceInfo & deviceInfo);
+
+	// Continues a 32 bit FNV-1a hash over size bytes of data. Start with LYNX_HASH_SEED.
+	uint32_t hashBytes(uint32_t hash, const char * data, int size);
+	// Returns a fingerprint of the struct ids, variable types and (optionally) descriptions in deviceInfo.
+	// The device id is not included, since it can be changed at runtime.
+	uint32_t schemaHash(const LynxDeviceInfo & deviceInfo, bool includeDescriptions = true);
+
     E_LynxAccessMode accessMode(E_LynxDataType dataType);
 }
 
@@ -234,9 +343,14 @@ union LynxUnion
 
 struct LynxVariableInfo
 {
+	LynxVariableInfo() : index(0), dataType(LynxLib::eNotInitialized), arrayLength(0), scale(1.0f), offset(0.0f) {}
+
 	char index;
 	LynxLib::E_LynxDataType dataType;
 	LynxString description;
+	int arrayLength; // Number of elements of an array type (0 otherwise)
+	float scale;	// Scaling of eScaled16 (1 and 0 otherwise)
+	float offset;
 };
 
 struct LynxStructInfo
@@ -284,6 +398,37 @@ struct LynxId
 	int variableIndex;
 };
 
+class LynxNameIndex
+{
+public:
+	LynxNameIndex() {}
+
+	void clear();
+	void insert(uint32_t hash, const LynxId & lynxId);
+
+	// Returns the first entry with a matching hash, or -1 if there are none
+	int first(uint32_t hash) const;
+	// Returns the next entry with the same hash as entry, or -1 if there are no more
+	int next(int entry) const;
+
+	const LynxId & lynxId(int entry) const { return _entries.at(entry).lynxId; }
+
+private:
+	struct Entry
+	{
+		Entry() : hash(0), next(-1) {}
+
+		uint32_t hash;
+		LynxId lynxId;
+		int next;
+	};
+
+	LynxList<Entry> _entries;
+	LynxList<int> _buckets; // Index of the first entry in every bucket (count is always a power of two)
+
+	void rehash(int bucketCount);
+};
+
 struct LynxDynamicId
 {
     LynxDynamicId() : structId(0) {}
@@ -293,13 +438,80 @@ struct LynxDynamicId
 	LynxList<LynxId> variableIds;
 };
 
+struct LynxViewId
+{
+	explicit LynxViewId(int _viewIndex = -1) : viewIndex(_viewIndex) {}
+
+	bool operator == (const LynxViewId & other) const { return (viewIndex == other.viewIndex); }
+	bool operator != (const LynxViewId & other) const { return (viewIndex != other.viewIndex); }
+
+	int viewIndex;
+};
+
+// A named list of targets (single variables or whole structs, possibly from several structs) that is transmitted as one datagram
+struct LynxView
+{
+	LynxView() : viewId(0), transferSize(-1) {}
+
+	char viewId;
+	LynxString name;
+	LynxList<LynxId> lynxIds;
+	int transferSize; // Precomputed size of the data, or -1 if it depends on the length of a string
+};
+
+// One step of the plan compiled by LynxStructure::freeze(): neighbouring variables with the same transfer width and access mode
+struct LynxPlanRun
+{
+	LynxPlanRun() : startIndex(0), count(0), width(0), readOnly(false), indirect(false) {}
+
+	int startIndex;
+	int count;
+	int width;		// Transfer size of each variable, or 0 for a string (always a run of one)
+	bool readOnly;
+	bool indirect;	// An array, a converted value (eHalf, eScaled16) or a value in external storage (always a run of one)
+};
+
+// Called for every received variable whose value changed. lynxId is the subscribed id with the variable index filled in.
+typedef void (*LynxChangeCallback)(const LynxId & lynxId, void * context);
+
+struct LynxSubscription
+{
+	LynxSubscription() : lynxId(), callback(LYNX_NULL), context(LYNX_NULL) {}
+
+	LynxId lynxId;			// A negative variable index subscribes to every variable of the struct
+	LynxChangeCallback callback;
+	void * context;
+};
+
+// Structures added by LynxManager::addInstances(), with consecutive struct indexes, sharing one schema
+struct LynxInstanceSet
+{
+	LynxInstanceSet() : schema(LYNX_NULL), firstIndex(-1), count(0) {}
+
+	LynxStructInfo * schema;	// Owned by the manager
+	int firstIndex;				// Struct index of the first instance
+	int count;
+};
+
+// Where the value of a variable is kept in an application struct, see LynxStructure::bind(). Use LYNX_BINDING() to fill it in.
+struct LynxBinding
+{
+	int variableIndex;
+	size_t offset;
+	size_t size;	// Must match the local size of the data type
+};
+
+#define LYNX_BINDING(variableIndex, type, field) { variableIndex, offsetof(type, field), sizeof(((type *)0)->field) }
+
 struct LynxInfo
 {
-    LynxInfo() : deviceId(0), structId(0), lynxId(), dataLength(0), state(LynxLib::eNoChange) {}
+    LynxInfo() : deviceId(0), structId(0), lynxId(), variableCount(0), lynxViewId(), dataLength(0), state(LynxLib::eNoChange) {}
 
 	char deviceId;
     char structId;
 	LynxId lynxId;
+	int variableCount; // Number of variables starting at lynxId.variableIndex in a range datagram (0 otherwise)
+	LynxViewId lynxViewId; // The view that was received in a view datagram (invalid otherwise)
 	int dataLength;
 	LynxLib::E_LynxState state;
 };
@@ -332,7 +544,40 @@ public:
 	LynxType(const LynxType & other);// : LynxType(other._dataType, other._description) { *this = other; }
 	~LynxType();
 
-	void init(LynxLib::E_LynxDataType dataType, const LynxString * const description);
+	// arrayLength is the number of elements of an array type, and ignored for other types
+	void init(LynxLib::E_LynxDataType dataType, const LynxString * const description, int arrayLength = 0);
+	// Initializes the variable from info, which is owned by someone else (the schema of a structure) and must outlive
+	// the variable. The data type, array length, scaling and description are read from info, only the value is kept here.
+	void init(LynxVariableInfo * info);
+
+	// Moves the value to storage, which is owned by the caller from then on (strings are not moved)
+	void bindValue(LynxUnion * storage);
+	// The storage of the value, or null for strings and arrays
+	LynxUnion * value() { return _var; }
+	// The elements of an array type, contiguous in the local element type (null for other types)
+	void * arrayData() { return _array; }
+	const void * arrayData() const { return _array; }
+	int arrayLength() const { return (_info == LYNX_NULL) ? 0 : _info->arrayLength; }
+	// Keeps the value in a variable owned by the caller, which must have the local type of the data type.
+	// The current value is not copied, the variable is used as it is. Passing LYNX_NULL gives the value its own storage back.
+	void bindExternal(void * address);
+	bool bound() const { return _bound; }
+
+	// Scaling of eScaled16 variables, where value = raw * scale + offset. Values outside the range of the raw integer
+	// are clamped when sent. Both sides must use the same scaling, so it is part of the device info.
+	// Returns false (and changes nothing) for other data types or if scale is zero or either number isn't finite.
+	// Variables sharing their info (see init()) share the scaling as well.
+	bool setScaling(float scale, float offset);
+	float scale() const { return (_info == LYNX_NULL) ? 1.0f : _info->scale; }
+	float offset() const { return (_info == LYNX_NULL) ? 0.0f : _info->offset; }
+
+	// Refers to another copy of the info the variable was initialized with, e.g. after the schema holding it has moved.
+	// Only the reference changes, the value is kept.
+	void shareInfo(LynxVariableInfo * info);
+
+	// The value as raw bits. Only the bytes of the data type are touched, so values in external storage are never overrun.
+	uint64_t bits() const;
+	void setBits(uint64_t bits);
 
     LynxString description() const;
 	// void getInfo(LynxVariableInfo & variableInfo) const;
@@ -364,14 +609,26 @@ public:
 	const LynxString & var_string() const { return *_str; }
 	const bool & var_bool() const { return _var->_var_bool; }
 
-	LynxLib::E_LynxDataType dataType() const { return _dataType; }
-    bool readOnly() { return ((_dataType & 0x80) != 0); }
+	LynxLib::E_LynxDataType dataType() const { return (_info == LYNX_NULL) ? LynxLib::eNotInitialized : _info->dataType; }
+    bool readOnly() { return ((this->dataType() & 0x80) != 0); }
 
 	int localSize() const;
 	int transferSize() const;
 
     int toArray(LynxByteArray & buffer, LynxLib::E_LynxState & state) const;
+	// Writes the value directly to buffer, which must have room for transferSize() bytes
+	int toArray(char * buffer, LynxLib::E_LynxState & state) const;
     int fromArray(const LynxByteArray & buffer, int startIndex, LynxLib::E_LynxState & state);
+	// Reads the value directly from buffer, where size is the number of bytes available.
+	// Read only values are skipped unless writeReadOnly is set.
+	// If valueChanged is given it is set to whether the stored value differs from the one before.
+	int fromArray(const char * buffer, int size, LynxLib::E_LynxState & state, bool writeReadOnly = false, bool * valueChanged = LYNX_NULL);
+
+	// Same as toArray() and fromArray(), except that eHalf and eScaled16 are kept as the local float, so a snapshot
+	// restores them exactly. Read only values are always read.
+	int snapshotSize() const;
+	int toSnapshot(char * buffer, LynxLib::E_LynxState & state) const;
+	int fromSnapshot(const char * buffer, int size, LynxLib::E_LynxState & state, bool * valueChanged = LYNX_NULL);
 
 	// If the program assumes the wrong endianness it can be set manually with this function
 	static void setEndianness(LynxLib::E_Endianness endianness) { LynxType::_endianness = endianness; }
@@ -383,16 +640,35 @@ public:
 		if (&other == this)
 			return *this;
 
-		if (_dataType == LynxLib::eNotInitialized)
-			this->init(other._dataType, other._description);
+		if (_info == LYNX_NULL)
+		{
+			if (other._ownsInfo)
+			{
+				this->init(other.dataType(), &other._info->description, other.arrayLength());
+				_info->scale = other.scale();
+				_info->offset = other.offset();
+			}
+			else
+			{
+				this->init(other._info);
+			}
+
+			// A new copy (e.g. when the variable list grows) keeps using the same external storage
+			if (other._bound)
+			{
+				this->bindExternal(other._var);
+				return *this;
+			}
+		}
 
 		if ((_var != LYNX_NULL) && (other._var != LYNX_NULL))
-			_var->_var_i64 = other._var->_var_i64;
+			this->setBits(other.bits());
 
 		if ((_str != LYNX_NULL) && (other._str != LYNX_NULL))
 			*_str = *(other._str);
 
-		// _dataType = other._dataType;
+		if ((_array != LYNX_NULL) && (other._array != LYNX_NULL) && (this->arrayLength() == other.arrayLength()))
+			memcpy(_array, other._array, this->localSize());
 
 		return *this;
     }
@@ -400,13 +676,45 @@ public:
 private:
 	LynxUnion * _var;
 	LynxString * _str;
+	LynxUnion * _array;	// Elements of an array type (a LynxUnion block, so every element type is aligned)
+	LynxVariableInfo * _info;	// Data type, array length, scaling and description, null until initialized
 
-	LynxString * _description; // optional
+	bool _ownsValue;	// False when _var is part of the value block of a LynxStructure, or bound to external storage
+	bool _bound;		// True when _var is owned by the application (see bindExternal())
+	bool _ownsInfo;		// False when the info belongs to the schema of a structure
 
-	LynxLib::E_LynxDataType _dataType;
     static LynxLib::E_Endianness _endianness;
 
+	void releaseValue();
+
+	// The raw wire value of eHalf and eScaled16, and back
+	uint16_t encodeConverted() const;
+	float decodeConverted(uint16_t raw) const;
+};
+
+#ifdef LYNX_MULTITHREAD
+// Reader-writer spin lock used by the thread safe mode of LynxStructure.
+// Any number of readers can hold the lock at once, and read locks can be nested. The thread that holds
+// the write lock can take both read and write locks again, so locked functions can call each other.
+class LynxReadWriteLock
+{
+public:
+	LynxReadWriteLock() : _state(0), _writer(std::thread::id()), _writeDepth(0) {}
+
+	void lockRead();
+	void unlockRead();
+	void lockWrite();
+	void unlockWrite();
+
+private:
+	std::atomic<int32_t> _state;	// Number of readers, or -1 while a writer holds the lock
+	std::atomic<std::thread::id> _writer;
+	int _writeDepth;				// Only touched by the writer
+
+	LynxReadWriteLock(const LynxReadWriteLock &);
+	LynxReadWriteLock & operator = (const LynxReadWriteLock &);
 };
+#endif // LYNX_MULTITHREAD
 
 //-----------------------------------------------------------------------------------------------------------
 //---------------------------------------- LynxStructure ----------------------------------------------------
@@ -420,9 +728,34 @@ public:
 
 	const LynxStructure & operator = (const LynxStructure & other)
 	{
-		this->init(other._structId, other._description, other._count);
+		// Instances keep sharing the schema, other structures get a copy of their own
+		this->initStructure(other._structId, other._description, other._enableReadOnly, other._count, other._ownsSchema ? LYNX_NULL : other._schema);
 
 		LynxList::operator=(other);
+
+		if (other._ownsSchema)
+			_schema->variables = other._schema->variables;
+
+		this->bindInfos();
+		this->bindValues();
+
+		_boundCount = other._boundCount;
+
+		_changed = other._changed;
+		_changeStamps = other._changeStamps;
+		_changeStamp = other._changeStamp;
+		_received = other._received;
+		_subscriptions = other._subscriptions;
+
+		_fixedTransferSize = other._fixedTransferSize;
+		_fixedLocalSize = other._fixedLocalSize;
+		_stringIndexes = other._stringIndexes;
+
+		if (other._frozen)
+			this->freeze();
+
+		this->setConcurrencyMode(other._concurrencyMode);
+		_threadSafe = other._threadSafe;
 			
 		return *this;
 	}
@@ -433,6 +766,12 @@ public:
 	using LynxList::reserve;
 
 	void init(char structId, const LynxString * const description, bool enableReadOnly = false, int size = 0);
+	/// Initializes the structure with all the variables in structInfo at once. Returns false if any of the data types are invalid.
+	bool init(const LynxStructInfo & structInfo, bool enableReadOnly = false);
+	/// Same as above, but the variables refer to the variables of schema (data types, array lengths, scaling and descriptions)
+	/// instead of keeping a copy of their own, so the structure only holds the values. schema must outlive the structure, and
+	/// must have the read only specifiers removed unless enableReadOnly is set. The struct id and description of schema are not used.
+	bool init(char structId, const LynxString & description, LynxStructInfo & schema, bool enableReadOnly = false);
 
 	void getInfo(LynxStructInfo & structInfo) const;
 	LynxStructInfo getInfo() const;
@@ -443,18 +782,63 @@ public:
 	/// Copies the required information to the char array
 	LynxLib::E_LynxState toArray(char * buffer, int maxSize, int & copiedSize, int variableIndex = -1) const;
 
-	/// Copies information from the provided buffer
+	/// Copies variableCount variables starting at startIndex to the provided buffer
+	LynxLib::E_LynxState toArray(LynxByteArray & buffer, int startIndex, int variableCount) const;
+
+	/// Copies variableCount variables starting at startIndex to the char array
+	LynxLib::E_LynxState toArray(char * buffer, int maxSize, int & copiedSize, int startIndex, int variableCount) const;
+
+	/// Copies the variables selected in variableMask (one bit per variable) to the provided buffer
+	LynxLib::E_LynxState toArray(LynxByteArray & buffer, const LynxByteArray & variableMask) const;
+
+	/// Copies the variables selected in variableMask (one bit per variable) to the char array
+	LynxLib::E_LynxState toArray(char * buffer, int maxSize, int & copiedSize, const LynxByteArray & variableMask) const;
+
+	/// Copies information from the provided buffer (regular or delta datagram)
     void fromArray(const LynxByteArray & buffer, LynxInfo & lynxInfo);
 
-	/// Copies information from char array, and returns number of bytes copied
+	/// Copies information directly from the char array, without copying the array
     void fromArray(const char * buffer, int size, LynxInfo & lynxInfo);
 
-	/// Manually add a variable to the variable list
-	LynxId addVariable(int structIndex, LynxLib::E_LynxDataType dataType, const LynxString & description = "");
+	/// Copies a bare payload (no header or checksum) to the variable(s) selected by lynxInfo.lynxId.variableIndex,
+	/// or to lynxInfo.variableCount variables starting at lynxInfo.lynxId.variableIndex if it is above zero
+	/// Returns the number of bytes read.
+	int fromData(const char * data, int dataLength, LynxInfo & lynxInfo);
+
+	/// Number of bytes toSnapshot() adds
+	int snapshotSize() const;
+	/// Appends the values of all variables to buffer like toArray() without header and checksum, except that
+	/// eHalf and eScaled16 keep their local float (see LynxType::toSnapshot()). Used to save snapshots.
+	LynxLib::E_LynxState toSnapshot(LynxByteArray & buffer) const;
+	/// Reads the values written by toSnapshot(), read only variables included. Used to restore snapshots.
+	/// Returns the number of bytes read.
+	int fromSnapshot(const char * data, int dataLength, LynxInfo & lynxInfo);
+
+	/// Manually add a variable to the variable list. Array types need arrayLength elements, where
+	/// the data of the array must fit in a range datagram (65535 bytes), other types must leave it at 0.
+	/// Refused in eDoubleBuffer mode, and for structures sharing their schema.
+	LynxId addVariable(int structIndex, LynxLib::E_LynxDataType dataType, const LynxString & description = "", int arrayLength = 0);
+
+	/// Compiles the variables into a flat plan, used by toArray() and fromArray() for ranges and whole structures:
+	/// the wire offset of every variable, and runs of neighbouring variables with the same width that are copied
+	/// without dispatching on the data type. addVariable() rebuilds the plan. Has no effect on big endian targets.
+	void freeze();
+	bool frozen() const { return _frozen; }
+
+	/// Copies variableCount variables starting at sourceIndex in source to the variables starting at targetIndex.
+	/// The data types (and array lengths) of both ranges must match. Numbers are copied as one block, only strings and arrays are copied one by one.
+	/// Returns false if the ranges are out of bounds or the data types differ.
+	bool copyRange(const LynxStructure & source, int sourceIndex, int targetIndex, int variableCount);
 
 	/// Returns the transfersize of requested data (not including header and checksum)
 	int transferSize(int variableIndex = -1) const;
 
+	/// Returns the transfersize of variableCount variables starting at startIndex, or 0 if the range is out of bounds
+	int transferSize(int startIndex, int variableCount) const;
+
+	/// Returns the transfersize of the variables selected in variableMask (not including header, bitmap and checksum)
+	int transferSize(const LynxByteArray & variableMask) const;
+
 	/// Returns the local size of requested data (not including header and checksum)
 	int localSize(int variableIndex = -1) const;
 
@@ -462,10 +846,181 @@ public:
 
     LynxString description() const;
 
+	/// Marks a variable as changed. All variables are marked if variableIndex is negative
+	void setChanged(int variableIndex = -1);
+
+	/// Returns true if the variable has changed since it was last cleared. Checks all variables if variableIndex is negative
+	bool changed(int variableIndex = -1) const;
+
+	/// Clears the change flag of a variable. All flags are cleared if variableIndex is negative
+	void clearChanged(int variableIndex = -1);
+
+	/// Returns the number of variables marked as changed
+	int changedCount() const;
+
+	/// Bitmap with one bit per variable (bit n of byte m is variable m * 8 + n)
+	const LynxByteArray & changedMask() const { return _changed; }
+
+	/// Stamp of the latest change, never 0. Every sender keeps the stamp of its last transmit and asks
+	/// changedSince() for the newer changes, so senders don't clear each other's change flags.
+	/// Stamps wrap around, so a variable that was left alone for 2^31 changes may be reported once more.
+	uint32_t changeStamp() const { return _changeStamp; }
+	/// Returns true if any of variableCount variables from variableIndex has changed after stamp. Everything has changed after stamp 0.
+	bool changedSince(uint32_t stamp, int variableIndex, int variableCount = 1) const;
+	/// Fills mask with one bit per variable changed after stamp, and returns the number of changed variables
+	int changedSince(uint32_t stamp, LynxByteArray & mask) const;
+
+	/// Keeps the value of a variable in the application's own storage, so toArray() and fromArray() read and write it directly.
+	/// address must point to a variable of the local type of the data type (e.g. float for eFloat) that outlives the binding.
+	/// Only the bytes of that type are ever accessed, so the variable needs no more than its own alignment.
+	/// The variable is used as it is, its current value is not copied. Passing LYNX_NULL gives the value its own storage back.
+	/// Returns false for strings, arrays and invalid indexes.
+	bool bind(int variableIndex, void * address);
+	/// Binds several variables to the fields of the application struct at base, e.g. LYNX_BINDING(0, MyStruct, speed).
+	/// Nothing is bound and false is returned if any of the bindings is invalid or has the wrong size.
+	bool bind(void * base, const LynxBinding * bindings, int count);
+
+	/// Calls callback from fromArray() for every received variable whose value is different from before.
+	/// A negative variable index in lynxId subscribes to every variable, the struct index is only passed back to the callback.
+	/// Callbacks run on the decoding thread after the frame has been read, with the structure still locked in thread safe mode.
+	void subscribe(const LynxId & lynxId, LynxChangeCallback callback, void * context = LYNX_NULL);
+	/// Removes the subscriptions of lynxId.variableIndex with the same callback and context
+	void unsubscribe(const LynxId & lynxId, LynxChangeCallback callback, void * context = LYNX_NULL);
+
+	/// The concurrency mode only has an effect when LYNX_MULTITHREAD is defined.
+	/// eDoubleBuffer must be set after all variables have been added, addVariable() is refused while it is set.
+	void setConcurrencyMode(LynxLib::E_LynxConcurrencyMode mode);
+	LynxLib::E_LynxConcurrencyMode concurrencyMode() const { return _concurrencyMode; }
+
+	/// Brackets a write in seqlock mode. fromArray(), the LynxManager set functions and LynxVar do this by themselves,
+	/// writes through a bound variable or a raw pointer must call these if readers use snapshot(). Only one writer at a time is allowed.
+	/// Brackets nest, so several writes can be made to look like one by bracketing them again.
+	void beginWrite();
+	void endWrite();
+
+	/// Copies the value of every variable to values (string and array variables are left blank).
+	/// In seqlock mode the copy is retried until it was not interleaved with a write, so the
+	/// result is always a consistent image of the structure. Returns the number of retries.
+	int snapshot(LynxList<LynxUnion> & values) const;
+
+	/// Returns the values of the latest completely decoded frame, one LynxUnion per variable (string and array variables are left blank).
+	/// Only available in double buffer mode, otherwise LYNX_NULL is returned. The returned values stay untouched until the next call.
+	/// Never blocks and never retries, but only one reader thread is allowed: the blocks are exchanged with that one thread.
+	/// Frames are checked before anything is written, so a refused frame never reaches the reader. Only received frames are
+	/// published. Application writes (set functions, LynxVar) are not, they reach the reader with the next received frame.
+	const LynxUnion * latest();
+
+	/// Enables the reader-writer lock of the structure. Only has an effect when LYNX_MULTITHREAD is defined.
+	/// Must be set before the structure is shared between threads.
+	void setThreadSafe(bool enable) { _threadSafe = enable; }
+	bool threadSafe() const { return _threadSafe; }
+
+	/// The lock functions do nothing unless thread safe mode is enabled. Prefer LynxReadLocker and LynxWriteLocker.
+	void lockRead() const;
+	void unlockRead() const;
+	void lockWrite() const;
+	void unlockWrite() const;
+
 private:
 	char _structId;
 	LynxString * _description;
 	bool _enableReadOnly;
+
+	// The data type, array length, scaling and description of every variable, in variable order. The variables refer
+	// to this (see bindInfos()). Owned by the structure, unless it shares the schema of the manager with other instances.
+	LynxStructInfo * _schema;
+	bool _ownsSchema;
+
+	LynxByteArray _changed;
+	LynxList<uint32_t> _changeStamps;	// Stamp of the latest change of every variable, 0 if never changed
+	uint32_t _changeStamp;
+	LynxByteArray _received;	// Variables changed by the frame being decoded, only kept while there are subscriptions
+	LynxList<LynxSubscription> _subscriptions;
+	LynxLib::E_LynxConcurrencyMode _concurrencyMode;
+	bool _threadSafe;
+
+	// The values of all the variables, in variable order. The variables point into this block (see bindValues()).
+	LynxUnion * _values;
+	int _boundCount;	// Variables kept in external storage instead of the value block (see bind())
+
+	// Sizes of all variables except strings, kept up to date as variables are added.
+	// Strings can change size through var_string(), so they are summed on demand.
+	int _fixedTransferSize;
+	int _fixedLocalSize;
+	LynxList<int> _stringIndexes;
+
+	// Compiled by freeze()
+	bool _frozen;
+	bool _planStrings;			// The plan has string runs, so sizes are not fixed
+	LynxList<LynxPlanRun> _plan;
+	LynxList<int> _offsets;		// Wire offset of each variable (one extra entry for the end), not counting strings
+
+#ifdef LYNX_MULTITHREAD
+	mutable LynxReadWriteLock _lock;
+	std::atomic<uint32_t> _sequence;
+	int _writeNesting;			// Brackets opened by the writer, only the outermost one moves the sequence
+
+	// Double buffer mode uses three value blocks: one owned by the writer, one owned by the reader and one
+	// holding the latest published frame. Publishing and picking up a frame are single atomic exchanges.
+	LynxUnion * _buffers;
+	int _bufferCount;
+	int _writeBuffer;
+	int _readBuffer;
+	std::atomic<int> _publishedBuffer;
+#endif // LYNX_MULTITHREAD
+
+	void copyValues(LynxList<LynxUnion> & values) const;
+	void storeValues(LynxUnion * block, int count) const;
+	// Moves the values of all variables to a new value block. Must be called whenever variables are added or reallocated.
+	void bindValues();
+	// Points the variables at their entries in the schema. Must be called whenever the schema has moved.
+	void bindInfos();
+	// Shares schema, or gives the structure a schema of its own if schema is null
+	void useSchema(LynxStructInfo * schema);
+	// init() with a shared schema, or a schema of its own if schema is null
+	void initStructure(char structId, const LynxString * const description, bool enableReadOnly, int size, LynxStructInfo * schema);
+	bool initVariables(const LynxStructInfo & structInfo);
+	void cacheSizes(int variableIndex);
+	void clearPlan();
+	int planRun(int variableIndex) const;
+	int encodePlan(char * buffer, int startIndex, int variableCount, LynxLib::E_LynxState & state) const;
+	int decodePlan(const char * data, int dataLength, int startIndex, int variableCount, LynxInfo & lynxInfo, bool writeReadOnly);
+	void publish();
+	// Calls the subscriptions of the variables marked in _received, and clears them
+	void notify();
+	int readData(const char * data, int dataLength, LynxInfo & lynxInfo);
+	int readRange(const char * data, int dataLength, int startIndex, int variableCount, LynxInfo & lynxInfo, bool writeReadOnly = false);
+	int readDelta(const char * data, int dataLength, LynxInfo & lynxInfo);
+	// Checks that the variables addressed by lynxInfo fit in dataLength (fill it exactly if exact is set), without reading them
+	LynxLib::E_LynxState checkData(const char * data, int dataLength, const LynxInfo & lynxInfo, bool delta, bool exact) const;
+};
+
+// Holds the read lock of a structure while in scope (see LynxManager::setThreadSafe())
+class LynxReadLocker
+{
+public:
+	explicit LynxReadLocker(const LynxStructure & structure) : _structure(structure) { _structure.lockRead(); }
+	~LynxReadLocker() { _structure.unlockRead(); }
+
+private:
+	const LynxStructure & _structure;
+
+	LynxReadLocker(const LynxReadLocker &);
+	LynxReadLocker & operator = (const LynxReadLocker &);
+};
+
+// Holds the write lock of a structure while in scope (see LynxManager::setThreadSafe())
+class LynxWriteLocker
+{
+public:
+	explicit LynxWriteLocker(const LynxStructure & structure) : _structure(structure) { _structure.lockWrite(); }
+	~LynxWriteLocker() { _structure.unlockWrite(); }
+
+private:
+	const LynxStructure & _structure;
+
+	LynxWriteLocker(const LynxWriteLocker &);
+	LynxWriteLocker & operator = (const LynxWriteLocker &);
 };
 
 //-----------------------------------------------------------------------------------------------------------
@@ -478,12 +1033,19 @@ public:
 	LynxManager(char deviceId = char(0xff), const LynxString & description = "", int size = 0);
 	~LynxManager();
 
-	using LynxList::count;
+	// Number of structures. With LYNX_MULTITHREAD this only counts structures that are completely added (see setThreadSafe()).
+#ifdef LYNX_MULTITHREAD
+	int count() const { return _structCount.load(std::memory_order_acquire); }
+#else
+	int count() const { return _count; }
+#endif // LYNX_MULTITHREAD
 
 	const LynxVersion & getVersion() const { return _version; }
 	
 	void getInfo(LynxDeviceInfo & deviceInfo) const;
 	LynxDeviceInfo getInfo() const;
+	// Same as LynxLib::schemaHash(getInfo(), includeDescriptions)
+	uint32_t schemaHash(bool includeDescriptions = true) const;
 
     LynxString getStructName(const LynxId & lynxId);
     LynxString getVariableName(const LynxId & lynxId);
@@ -495,7 +1057,11 @@ public:
 	LynxType & variable(const LynxId & lynxId);
 	const LynxType & variable(const LynxId & lynxId) const;
 
+	// Copies the source variable to the target variable. If both variable indexes are -1 the whole struct is copied,
+	// which requires the two structs to have the same variables. Numbers are copied as one block of memory.
 	void copy(const LynxId & source, const LynxId & target);
+	// Copies variableCount variables starting at source to the variables starting at target (same data types required)
+	void copy(const LynxId & source, const LynxId & target, int variableCount);
 
 	// Copies the desired information to the provided buffer
 	LynxLib::E_LynxState toArray(LynxByteArray & buffer, const LynxId & lynxId) const;
@@ -503,18 +1069,59 @@ public:
 	// Copies the required information to the char array, and returns number of bytes copied
 	LynxLib::E_LynxState toArray(char * buffer, int maxSize, int & copiedSize, const LynxId & lynxId) const;
 
-	// Copies information from the provided buffer
-	void fromArray(const LynxByteArray & buffer, LynxInfo & lynxInfo);
+	// Copies the variables selected in variableMask to the provided buffer as a delta datagram
+	LynxLib::E_LynxState toArray(LynxByteArray & buffer, const LynxId & lynxId, const LynxByteArray & variableMask) const;
+
+	// Copies the variables selected in variableMask to the char array as a delta datagram
+	LynxLib::E_LynxState toArray(char * buffer, int maxSize, int & copiedSize, const LynxId & lynxId, const LynxByteArray & variableMask) const;
+
+	// Copies variableCount variables starting at lynxId.variableIndex to the provided buffer as a range datagram
+	LynxLib::E_LynxState toArray(LynxByteArray & buffer, const LynxId & lynxId, int variableCount) const;
 
-	// Copies information from char array, and returns number of bytes copied
-	void fromArray(const char * buffer, int size, LynxInfo & lynxInfo);
+	// Copies variableCount variables starting at lynxId.variableIndex to the char array as a range datagram
+	LynxLib::E_LynxState toArray(char * buffer, int maxSize, int & copiedSize, const LynxId & lynxId, int variableCount) const;
+
+	// Copies the targets of the view to the provided buffer as a view datagram
+	LynxLib::E_LynxState toArray(LynxByteArray & buffer, const LynxViewId & lynxViewId) const;
+
+	// Copies the targets of the view to the char array as a view datagram
+	LynxLib::E_LynxState toArray(char * buffer, int maxSize, int & copiedSize, const LynxViewId & lynxViewId) const;
+
+	// Copies all the targets in lynxIds to the provided buffer as one batch datagram
+	LynxLib::E_LynxState toArray(LynxByteArray & buffer, const LynxList<LynxId> & lynxIds) const;
+
+	// Copies all the targets in lynxIds to the char array as one batch datagram
+	LynxLib::E_LynxState toArray(char * buffer, int maxSize, int & copiedSize, const LynxList<LynxId> & lynxIds) const;
+
+	// Copies information from the provided buffer.
+	// If batchContents is provided it is filled with the targets received in a batch datagram.
+	void fromArray(const LynxByteArray & buffer, LynxInfo & lynxInfo, LynxList<LynxId> * batchContents = LYNX_NULL);
+
+	// Validates and copies information directly from the char array, without copying the array
+	void fromArray(const char * buffer, int size, LynxInfo & lynxInfo, LynxList<LynxId> * batchContents = LYNX_NULL);
 
 	int transferSize(const LynxId & lynxId) const;
+	int transferSize(const LynxId & lynxId, int variableCount) const;
+	int transferSize(const LynxViewId & lynxViewId) const;
+	// Returns the size of the complete batch datagram for lynxIds, or -1 if any of the targets are invalid
+	int batchSize(const LynxList<LynxId> & lynxIds) const;
+	int transferSize(const LynxId & lynxId, const LynxByteArray & variableMask) const;
 	int localSize(const LynxId & lynxId) const;
 
 	LynxId addStructure(char structId, const LynxString & description = "", bool enableReadOnly = false, int size = 0);
 	LynxDynamicId addStructure(const LynxStructInfo & structInfo, bool enableReadOnly = false);
-    LynxId addVariable(const LynxId & parentStruct, LynxLib::E_LynxDataType dataType, const LynxString & description = "");
+	// Adds count structures with the variables of schema, with the struct ids firstStructId, firstStructId + 1 and so on,
+	// named schema.description followed by the instance number. The manager keeps one copy of schema, which holds the data
+	// types, array lengths, scaling and descriptions of the variables of all instances. Each instance only has its value block
+	// and a value reference per variable. Scaling set on one instance applies to all of them, and variables can't be added.
+	// Returns the first instance, or an invalid id (with nothing added) if a struct id or name is taken or a data type is invalid.
+	LynxId addInstances(const LynxStructInfo & schema, char firstStructId, int count, bool enableReadOnly = false);
+	// The id of variableIndex in instance number n, where firstInstance was returned by addInstances(). Returns an invalid id
+	// if firstInstance is not the first of a set of instances, or n or variableIndex is out of range.
+	LynxId instance(const LynxId & firstInstance, int n, int variableIndex = -1) const;
+    LynxId addVariable(const LynxId & parentStruct, LynxLib::E_LynxDataType dataType, const LynxString & description = "", int arrayLength = 0);
+	// Adds a variable of an array type (e.g. eFloatArray_RW) with arrayLength elements. See LynxStructure::addVariable()
+	LynxId addArray(const LynxId & parentStruct, LynxLib::E_LynxDataType dataType, int arrayLength, const LynxString & description = "");
 
 	LynxLib::E_LynxDataType dataType(const LynxId & lynxId) const;
     LynxLib::E_LynxSimplifiedType simplifiedType(const LynxId & lynxId) const;
@@ -533,15 +1140,184 @@ public:
 	void setBit(int bit, bool value, const LynxId & lynxId);
 	bool getBit(int bit, const LynxId & lynxId) const;
 
+	// Number of elements of an array variable (0 for other variables)
+	int arrayLength(const LynxId & lynxId) const;
+	// Copies count elements of an array variable from values, which holds them in the local element type (e.g. float for
+	// eFloatArray), to the elements starting at firstElement. Returns the number of elements copied (cut off at the end of the array).
+	int setArray(const void * values, const LynxId & lynxId, int firstElement, int count);
+	// Copies count elements starting at firstElement to values. Returns the number of elements copied.
+	int getArray(void * values, const LynxId & lynxId, int firstElement, int count) const;
+	// A single element as a number, like setValue() and getValue()
+	void setElement(double value, const LynxId & lynxId, int element);
+	double getElement(const LynxId & lynxId, int element) const;
+
+	// Sets the scaling of an eScaled16 variable. Must be done before the device info is sent. See LynxType::setScaling()
+	bool setScaling(const LynxId & lynxId, float scale, float offset);
+
+	void setConcurrencyMode(const LynxId & lynxId, LynxLib::E_LynxConcurrencyMode mode);
+
+	// Returns the latest completely decoded frame of the struct in lynxId. Only one reader thread is allowed, see LynxStructure::latest()
+	const LynxUnion * latest(const LynxId & lynxId);
+
+	// Copies the values of the struct in lynxId to values. See LynxStructure::snapshot()
+	int snapshot(const LynxId & lynxId, LynxList<LynxUnion> & values) const;
+	// Brackets a write to the struct of lynxId in seqlock mode. See LynxStructure::beginWrite()
+	void beginWrite(const LynxId & lynxId);
+	void endWrite(const LynxId & lynxId);
+
+	// Change tracking. A negative variable index in lynxId addresses the whole struct
+	void setChanged(const LynxId & lynxId);
+	bool changed(const LynxId & lynxId) const;
+	void clearChanged(const LynxId & lynxId);
+	// Returns the number of changed variables in the struct of lynxId
+	int changedCount(const LynxId & lynxId) const;
+	// Returns the change bitmap of the struct of lynxId (one bit per variable)
+	const LynxByteArray & changedMask(const LynxId & lynxId) const;
+	// Per sender change tracking, see LynxStructure::changeStamp()
+	uint32_t changeStamp(const LynxId & lynxId) const;
+	bool changedSince(const LynxId & lynxId, uint32_t stamp, int variableCount = 1) const;
+	int changedSince(const LynxId & lynxId, uint32_t stamp, LynxByteArray & mask) const;
+
+	// Keeps the value of lynxId in the application's own variable at address. See LynxStructure::bind()
+	bool bind(const LynxId & lynxId, void * address);
+	// Binds variables of the struct of lynxId to the fields of the application struct at base, e.g.
+	//	LynxBinding bindings[] = { LYNX_BINDING(0, Motor, speed), LYNX_BINDING(1, Motor, current) };
+	//	lynx.bind(motorStruct, &motor, bindings, 2);
+	bool bind(const LynxId & lynxId, void * base, const LynxBinding * bindings, int count);
+
+	// Calls callback when a received frame changes the value of lynxId. A negative variable index subscribes to the whole struct.
+	// See LynxStructure::subscribe(). Returns false if lynxId is out of bounds.
+	// In thread safe mode the callback runs with the structure locked, so it must not add or look up names or views.
+	bool subscribe(const LynxId & lynxId, LynxChangeCallback callback, void * context = LYNX_NULL);
+	void unsubscribe(const LynxId & lynxId, LynxChangeCallback callback, void * context = LYNX_NULL);
+
 	// Returns number of variables in struct. Returns 0 if out of bounds
 	int structVariableCount(int structIndex);
 
-	int findId(char structId);
+	// Returns the struct index of structId, or -1 if it is not found
+	int findId(char structId) const;
+
+	// Returns the LynxId of the struct with the given description. The LynxId is invalid if it is not found
+	LynxId findStructure(const LynxString & description) const;
+	// Returns the LynxId of the first variable with the given description. The LynxId is invalid if it is not found
+	LynxId findVariable(const LynxString & description) const;
+	// Same as above, but only searches the variables of parentStruct
+	LynxId findVariable(const LynxString & description, const LynxId & parentStruct) const;
+
+	// Adds a view with the targets in lynxIds. A view with the same viewId is replaced.
+	// Returns an invalid LynxViewId if any of the targets are invalid.
+	LynxViewId addView(char viewId, const LynxList<LynxId> & lynxIds, const LynxString & name = "");
+	// Returns the LynxViewId of the view with the given id. The LynxViewId is invalid if it is not found
+	LynxViewId findView(char viewId) const;
+	// Returns the LynxViewId of the view with the given name. The LynxViewId is invalid if it is not found
+	LynxViewId findView(const LynxString & name) const;
+	int viewCount() const { return _views.count(); }
+	const LynxView & view(const LynxViewId & lynxViewId) const { return _views.at(lynxViewId.viewIndex); }
+
+	// Enables the per structure reader-writer locks (only has an effect when LYNX_MULTITHREAD is defined).
+	// The value accessors, toArray() and fromArray() then only lock the structures they touch, so different
+	// structures can be used from different threads at the same time. variable() and LynxVar are not locked,
+	// hold a LynxReadLocker or LynxWriteLocker on structure() while using them.
+	// Room for LYNX_MAX_STRUCTS structures is allocated, so structures never move once they are added.
+	// A new structure is built completely and then published with a single atomic store of the count,
+	// so addStructure() can run while other threads decode, without either side waiting. addVariable() holds the
+	// write lock of its structure while the values move, but pointers taken from variable() before it must not be
+	// used after it. The name indexes and the views have a lock of their own, so structures, variables and views
+	// can be added and looked up at runtime. Only one thread may add structures at a time. view() is not locked,
+	// and loadSnapshot() and the destructor need the other threads to be stopped.
+	void setThreadSafe(bool enable);
+	bool threadSafe() const { return _threadSafe; }
+
+	// The structure of lynxId, for use with LynxReadLocker and LynxWriteLocker
+	const LynxStructure & structure(const LynxId & lynxId) const { return _data[lynxId.structIndex]; }
+
+	// Changes whenever the values of existing variables may have moved in memory (variables added, the
+	// structure list reallocated or cleared), so pointers to values must be looked up again (see LynxVarT)
+#ifdef LYNX_MULTITHREAD
+	uint32_t layoutVersion() const { return _layoutVersion.load(std::memory_order_acquire); }
+#else
+	uint32_t layoutVersion() const { return _layoutVersion; }
+#endif // LYNX_MULTITHREAD
+
+	// Compiles every structure into a flat encode/decode plan (see LynxStructure::freeze()).
+	// Structures added later are frozen as they are added, and adding variables rebuilds the plan of the structure.
+	void freeze();
+	bool frozen() const { return _frozen; }
+
+	// Writes the device id, description, all structures and their current values to buffer.
+	// Values are stored as they are sent, except eHalf and eScaled16, which keep their local float so they are restored exactly.
+	LynxLib::E_LynxState saveSnapshot(LynxByteArray & buffer) const;
+	// Replaces all structures with the contents of a snapshot from saveSnapshot(), reading directly from buffer.
+	// The structures are allocated once and filled in bulk. Views are removed, since they refer to the old structures.
+	// Instances become structures with schemas of their own, since the snapshot doesn't tell them apart.
+	// The snapshot is loaded into a separate manager first, so nothing changes if it fails.
+	LynxLib::E_LynxState loadSnapshot(const char * buffer, int size);
 
 private:
 	char _deviceId;
 	LynxString * _description;
 	const LynxVersion _version;
+
+#ifndef LYNX_NO_ID_TABLE
+	// Struct index + 1 for every possible struct id (0 means not found)
+#ifdef LYNX_MULTITHREAD
+	std::atomic<uint8_t> _idTable[256];
+#else
+	uint8_t _idTable[256];
+#endif // LYNX_MULTITHREAD
+#endif // !LYNX_NO_ID_TABLE
+
+	LynxNameIndex _structNames;
+	LynxNameIndex _variableNames;
+
+	LynxList<LynxView> _views;
+	LynxList<LynxInstanceSet> _instanceSets;	// Added with addInstances()
+
+	bool _threadSafe;
+	bool _frozen;
+#ifdef LYNX_MULTITHREAD
+	std::atomic<uint32_t> _layoutVersion;	// Read by LynxVarT on other threads
+#else
+	uint32_t _layoutVersion;
+#endif // LYNX_MULTITHREAD
+
+#ifdef LYNX_MULTITHREAD
+	std::atomic<int> _structCount;	// Published structures, the list itself is only touched by the thread adding structures
+	mutable LynxReadWriteLock _nameLock;	// The name indexes and the views
+#endif // LYNX_MULTITHREAD
+
+	// Holds the lock of the name indexes and the views while in scope, in thread safe mode
+	class LynxNameLocker
+	{
+	public:
+		LynxNameLocker(const LynxManager & manager, bool write) : _manager(manager), _write(write) { _manager.lockNames(_write); }
+		~LynxNameLocker() { _manager.unlockNames(_write); }
+
+	private:
+		const LynxManager & _manager;
+		bool _write;
+
+		LynxNameLocker(const LynxNameLocker &);
+		LynxNameLocker & operator = (const LynxNameLocker &);
+	};
+
+	void lockNames(bool write) const;
+	void unlockNames(bool write) const;
+
+	// Called after the values of existing variables have moved, see layoutVersion()
+	void layoutChanged();
+	bool canAddStructure(char structId, const LynxString & description) const;
+	// The unused entry after the last structure, growing the list if needed
+	LynxStructure & newStructure();
+	// Makes the structure from newStructure() visible and returns its index
+	int publishStructure();
+	void readBatch(const char * buffer, int size, LynxInfo & lynxInfo, LynxList<LynxId> * batchContents);
+	void readView(const char * buffer, int size, LynxInfo & lynxInfo);
+	void updateViewSize(LynxView & view) const;
+	// Adds the structures of deviceInfo and reads their values, for loadSnapshot()
+	LynxLib::E_LynxState readSnapshot(const LynxDeviceInfo & deviceInfo, const char * values, int valueLength);
+	// Swaps the structures, name indexes and device description with other. Views are removed.
+	void takeStructures(LynxManager & other);
 };
 
 //-----------------------------------------------------------------------------------------------------------
@@ -556,6 +1332,11 @@ public:
         _lynxId(lynxManager.addVariable(parentStruct, dataType, description))
     {}
 
+	LynxVar(LynxManager & lynxManager, const LynxId & parentStruct, LynxLib::E_LynxDataType dataType, int arrayLength, const LynxString & description = "") :
+		_lynxManager(&lynxManager),
+		_lynxId(lynxManager.addArray(parentStruct, dataType, arrayLength, description))
+	{}
+
     LynxVar(const LynxVar & other) :
         _lynxManager(other._lynxManager),
         _lynxId(other._lynxId)
@@ -580,145 +1361,171 @@ protected:
     const LynxId _lynxId;
 };
 
-class LynxVar_i8 : public LynxVar
+// Base of the typed variables. The value is reached through a pointer into the value block of the structure,
+// looked up on first use and again whenever LynxManager::layoutVersion() shows that the storage may have moved.
+// In thread safe mode a handle used while another thread adds or binds variables of its structure must hold
+// a LynxReadLocker or LynxWriteLocker on the structure, so the values can not move between the check and the access.
+template <typename T, T LynxUnion::*member, LynxLib::E_LynxDataType dataTypeRW, LynxLib::E_LynxDataType dataTypeRO>
+class LynxVarT : public LynxVar
 {
 public:
-    LynxVar_i8(LynxManager & lynxManager, const LynxId & parentStruct, const LynxString & description = "", bool readOnly = false) :
-        LynxVar(lynxManager, parentStruct, readOnly ? LynxLib::eInt8_RO : LynxLib::eInt8_RW, description) {}
-		
-	operator const int8_t&() const { return _lynxManager->variable(_lynxId).var_i8(); }
+	LynxVarT(LynxManager & lynxManager, const LynxId & parentStruct, const LynxString & description = "", bool readOnly = false) :
+		LynxVar(lynxManager, parentStruct, readOnly ? dataTypeRO : dataTypeRW, description), _value(LYNX_NULL), _layoutVersion(0) {}
 
-	const int8_t & operator = (const int8_t & other) 
+	LynxVarT(const LynxVarT & other) : LynxVar(other), _value(LYNX_NULL), _layoutVersion(0) {}
+
+	// Copies the value, each handle keeps its own pointer
+	const LynxVarT & operator = (const LynxVarT & other)
 	{
-		return (_lynxManager->variable(_lynxId).var_i8() = other);
+		LynxVar::operator=(other);
+		return *this;
 	}
-};
 
+	operator const T&() const { return *this->value(); }
 
-class LynxVar_u8 : public LynxVar
-{
-public:
-    LynxVar_u8(LynxManager & lynxManager, const LynxId & parentStruct, const LynxString & description = "", bool readOnly = false) :
-        LynxVar(lynxManager, parentStruct, readOnly ? LynxLib::eUint8_RO : LynxLib::eUint8_RW, description) {}
+	const T & operator = (const T & other)
+	{
+		T & value = *this->value();
+		if (value != other)
+		{
+			_lynxManager->beginWrite(_lynxId);
+			value = other;
+			_lynxManager->endWrite(_lynxId);
+			_lynxManager->setChanged(_lynxId);
+		}
+		return value;
+	}
 
-	operator const uint8_t&() const { return _lynxManager->variable(_lynxId).var_u8(); }
+private:
+	mutable T * _value;
+	mutable uint32_t _layoutVersion;
 
-	const uint8_t & operator = (const uint8_t & other)
+	T * value() const
 	{
-		return (_lynxManager->variable(_lynxId).var_u8() = other);
+		// The version is read before the pointer, so a move right after the lookup is caught on the next access
+		uint32_t layoutVersion = _lynxManager->layoutVersion();
+
+		if ((_value == LYNX_NULL) || (_layoutVersion != layoutVersion))
+		{
+			_value = &(_lynxManager->variable(_lynxId).value()->*member);
+			_layoutVersion = layoutVersion;
+		}
+
+		return _value;
 	}
-}; 
+};
 
-class LynxVar_i16 : public LynxVar
+class LynxVar_i8 : public LynxVarT<int8_t, &LynxUnion::_var_i8, LynxLib::eInt8_RW, LynxLib::eInt8_RO>
 {
 public:
-    LynxVar_i16(LynxManager & lynxManager, const LynxId & parentStruct, const LynxString & description = "", bool readOnly = false) :
-        LynxVar(lynxManager, parentStruct, readOnly ? LynxLib::eInt16_RO : LynxLib::eInt16_RW, description) {}
+	LynxVar_i8(LynxManager & lynxManager, const LynxId & parentStruct, const LynxString & description = "", bool readOnly = false) :
+		LynxVarT(lynxManager, parentStruct, description, readOnly) {}
 
-	operator const int16_t&() const { return _lynxManager->variable(_lynxId).var_i16(); }
-
-	const int16_t & operator = (const int16_t & other)
-	{
-		return (_lynxManager->variable(_lynxId).var_i16() = other);
-	}
+	using LynxVarT::operator =;
 };
 
-class LynxVar_u16 : public LynxVar
+class LynxVar_u8 : public LynxVarT<uint8_t, &LynxUnion::_var_u8, LynxLib::eUint8_RW, LynxLib::eUint8_RO>
 {
 public:
-    LynxVar_u16(LynxManager & lynxManager, const LynxId & parentStruct, const LynxString & description = "", bool readOnly = false) :
-        LynxVar(lynxManager, parentStruct, readOnly ? LynxLib::eUint16_RO : LynxLib::eUint16_RW, description) {}
+	LynxVar_u8(LynxManager & lynxManager, const LynxId & parentStruct, const LynxString & description = "", bool readOnly = false) :
+		LynxVarT(lynxManager, parentStruct, description, readOnly) {}
 
-	operator const uint16_t&() const { return _lynxManager->variable(_lynxId).var_u16(); }
-
-	const uint16_t & operator = (const uint16_t & other)
-	{
-		return (_lynxManager->variable(_lynxId).var_u16() = other);
-	}
+	using LynxVarT::operator =;
 };
 
-class LynxVar_i32 : public LynxVar
+class LynxVar_i16 : public LynxVarT<int16_t, &LynxUnion::_var_i16, LynxLib::eInt16_RW, LynxLib::eInt16_RO>
 {
 public:
-    LynxVar_i32(LynxManager & lynxManager, const LynxId & parentStruct, const LynxString & description = "", bool readOnly = false) :
-        LynxVar(lynxManager, parentStruct, readOnly ? LynxLib::eInt32_RO : LynxLib::eInt32_RW, description) {}
+	LynxVar_i16(LynxManager & lynxManager, const LynxId & parentStruct, const LynxString & description = "", bool readOnly = false) :
+		LynxVarT(lynxManager, parentStruct, description, readOnly) {}
 
-	operator const int32_t&() const { return _lynxManager->variable(_lynxId).var_i32(); }
-
-	const int32_t & operator = (const int32_t & other)
-	{
-		return (_lynxManager->variable(_lynxId).var_i32() = other);
-	}
+	using LynxVarT::operator =;
 };
 
-class LynxVar_u32 : public LynxVar
+class LynxVar_u16 : public LynxVarT<uint16_t, &LynxUnion::_var_u16, LynxLib::eUint16_RW, LynxLib::eUint16_RO>
 {
 public:
-    LynxVar_u32(LynxManager & lynxManager, const LynxId & parentStruct, const LynxString & description = "", bool readOnly = false) :
-        LynxVar(lynxManager, parentStruct, readOnly ? LynxLib::eUint32_RO : LynxLib::eUint32_RW, description) {}
+	LynxVar_u16(LynxManager & lynxManager, const LynxId & parentStruct, const LynxString & description = "", bool readOnly = false) :
+		LynxVarT(lynxManager, parentStruct, description, readOnly) {}
 
-	operator const uint32_t&() const { return _lynxManager->variable(_lynxId).var_u32(); }
-
-	const uint32_t & operator = (const uint32_t & other)
-	{
-		return (_lynxManager->variable(_lynxId).var_u32() = other);
-	}
+	using LynxVarT::operator =;
 };
 
-class LynxVar_i64 : public LynxVar
+class LynxVar_i32 : public LynxVarT<int32_t, &LynxUnion::_var_i32, LynxLib::eInt32_RW, LynxLib::eInt32_RO>
 {
 public:
-    LynxVar_i64(LynxManager & lynxManager, const LynxId & parentStruct, const LynxString & description = "", bool readOnly = false) :
-        LynxVar(lynxManager, parentStruct, readOnly ? LynxLib::eInt64_RO : LynxLib::eInt64_RW, description) {}
+	LynxVar_i32(LynxManager & lynxManager, const LynxId & parentStruct, const LynxString & description = "", bool readOnly = false) :
+		LynxVarT(lynxManager, parentStruct, description, readOnly) {}
 
-	operator const int64_t&() const { return _lynxManager->variable(_lynxId).var_i64(); }
+	using LynxVarT::operator =;
+};
 
-	const int64_t & operator = (const int64_t & other)
-	{
-		return (_lynxManager->variable(_lynxId).var_i64() = other);
-	}
+class LynxVar_u32 : public LynxVarT<uint32_t, &LynxUnion::_var_u32, LynxLib::eUint32_RW, LynxLib::eUint32_RO>
+{
+public:
+	LynxVar_u32(LynxManager & lynxManager, const LynxId & parentStruct, const LynxString & description = "", bool readOnly = false) :
+		LynxVarT(lynxManager, parentStruct, description, readOnly) {}
+
+	using LynxVarT::operator =;
 };
 
-class LynxVar_u64 : public LynxVar
+class LynxVar_i64 : public LynxVarT<int64_t, &LynxUnion::_var_i64, LynxLib::eInt64_RW, LynxLib::eInt64_RO>
 {
 public:
-    LynxVar_u64(LynxManager & lynxManager, const LynxId & parentStruct, const LynxString & description = "", bool readOnly = false) :
-        LynxVar(lynxManager, parentStruct, readOnly ? LynxLib::eUint64_RO : LynxLib::eUint64_RW, description) {}
+	LynxVar_i64(LynxManager & lynxManager, const LynxId & parentStruct, const LynxString & description = "", bool readOnly = false) :
+		LynxVarT(lynxManager, parentStruct, description, readOnly) {}
 
-	operator const uint64_t&() const { return _lynxManager->variable(_lynxId).var_u64(); }
+	using LynxVarT::operator =;
+};
 
-	const uint64_t & operator = (const uint64_t & other)
-	{
-		return (_lynxManager->variable(_lynxId).var_u64() = other);
-	}
+class LynxVar_u64 : public LynxVarT<uint64_t, &LynxUnion::_var_u64, LynxLib::eUint64_RW, LynxLib::eUint64_RO>
+{
+public:
+	LynxVar_u64(LynxManager & lynxManager, const LynxId & parentStruct, const LynxString & description = "", bool readOnly = false) :
+		LynxVarT(lynxManager, parentStruct, description, readOnly) {}
+
+	using LynxVarT::operator =;
 };
 
-class LynxVar_float : public LynxVar
+class LynxVar_float : public LynxVarT<float, &LynxUnion::_var_float, LynxLib::eFloat_RW, LynxLib::eFloat_RO>
 {
 public:
-    LynxVar_float(LynxManager & lynxManager, const LynxId & parentStruct, const LynxString & description = "", bool readOnly = false) :
-        LynxVar(lynxManager, parentStruct, readOnly ? LynxLib::eFloat_RO : LynxLib::eFloat_RW, description) {}
+	LynxVar_float(LynxManager & lynxManager, const LynxId & parentStruct, const LynxString & description = "", bool readOnly = false) :
+		LynxVarT(lynxManager, parentStruct, description, readOnly) {}
 
-	operator const float&() const { return _lynxManager->variable(_lynxId).var_float(); }
+	using LynxVarT::operator =;
+};
 
-	const float & operator = (const float & other)
-	{
-		return (_lynxManager->variable(_lynxId).var_float() = other);
-	}
+class LynxVar_double : public LynxVarT<double, &LynxUnion::_var_double, LynxLib::eDouble_RW, LynxLib::eDouble_RO>
+{
+public:
+	LynxVar_double(LynxManager & lynxManager, const LynxId & parentStruct, const LynxString & description = "", bool readOnly = false) :
+		LynxVarT(lynxManager, parentStruct, description, readOnly) {}
+
+	using LynxVarT::operator =;
 };
 
-class LynxVar_double : public LynxVar
+// A float that is sent as a half precision float
+class LynxVar_half : public LynxVarT<float, &LynxUnion::_var_float, LynxLib::eHalf_RW, LynxLib::eHalf_RO>
 {
 public:
-    LynxVar_double(LynxManager & lynxManager, const LynxId & parentStruct, const LynxString & description = "", bool readOnly = false) :
-        LynxVar(lynxManager, parentStruct, readOnly ? LynxLib::eDouble_RO : LynxLib::eDouble_RW, description) {}
+	LynxVar_half(LynxManager & lynxManager, const LynxId & parentStruct, const LynxString & description = "", bool readOnly = false) :
+		LynxVarT(lynxManager, parentStruct, description, readOnly) {}
 
-	operator const double&() const { return _lynxManager->variable(_lynxId).var_double(); }
+	using LynxVarT::operator =;
+};
 
-	const double & operator = (const double & other)
+// A float that is sent as a 16 bit integer, raw = (value - offset) / scale
+class LynxVar_scaled : public LynxVarT<float, &LynxUnion::_var_float, LynxLib::eScaled16_RW, LynxLib::eScaled16_RO>
+{
+public:
+	LynxVar_scaled(LynxManager & lynxManager, const LynxId & parentStruct, float scale, float offset = 0.0f, const LynxString & description = "", bool readOnly = false) :
+		LynxVarT(lynxManager, parentStruct, description, readOnly)
 	{
-		return (_lynxManager->variable(_lynxId).var_double() = other);
+		lynxManager.setScaling(_lynxId, scale, offset);
 	}
+
+	using LynxVarT::operator =;
 };
 
 class LynxVar_string : public LynxVar
@@ -731,7 +1538,15 @@ public:
 
 	const LynxString & operator = (const LynxString & other)
 	{
-		return (_lynxManager->variable(_lynxId).var_string() = other);
+		LynxString & value = _lynxManager->variable(_lynxId).var_string();
+		if (value != other)
+		{
+			_lynxManager->beginWrite(_lynxId);
+			value = other;
+			_lynxManager->endWrite(_lynxId);
+			_lynxManager->setChanged(_lynxId);
+		}
+		return value;
 	}
 
 	// bit accessors don't make any sense in a string
@@ -739,20 +1554,51 @@ public:
 	void setBit(int bit, bool value) = delete;
 };
 
-class LynxVar_bool : public LynxVar
+class LynxVar_bool : public LynxVarT<bool, &LynxUnion::_var_bool, LynxLib::eBoolean_RW, LynxLib::eBoolean_RO>
 {
 public:
 	LynxVar_bool(LynxManager & lynxManager, const LynxId & parentStruct, const LynxString & description = "", bool readOnly = false) :
-		LynxVar(lynxManager, parentStruct, readOnly ? LynxLib::eBoolean_RO : LynxLib::eBoolean_RW, description) {}
+		LynxVarT(lynxManager, parentStruct, description, readOnly) {}
+
+	using LynxVarT::operator =;
+};
+
+// An array variable. The elements are copied in and out in bulk, since the storage moves when variables are added.
+template <typename T, LynxLib::E_LynxDataType dataTypeRW, LynxLib::E_LynxDataType dataTypeRO>
+class LynxArrayT : public LynxVar
+{
+public:
+	LynxArrayT(LynxManager & lynxManager, const LynxId & parentStruct, int arrayLength, const LynxString & description = "", bool readOnly = false) :
+		LynxVar(lynxManager, parentStruct, readOnly ? dataTypeRO : dataTypeRW, arrayLength, description) {}
 
-	operator const bool&() const { return _lynxManager->variable(_lynxId).var_bool(); }
+	int length() const { return _lynxManager->arrayLength(_lynxId); }
 
-	const bool & operator = (const bool & other)
+	int set(const T * values, int count, int firstElement = 0) { return _lynxManager->setArray(values, _lynxId, firstElement, count); }
+	int get(T * values, int count, int firstElement = 0) const { return _lynxManager->getArray(values, _lynxId, firstElement, count); }
+
+	T at(int element) const
 	{
-		return (_lynxManager->variable(_lynxId).var_bool() = other);
+		T value = T();
+		_lynxManager->getArray(&value, _lynxId, element, 1);
+		return value;
 	}
+
+	// bit accessors don't make any sense in an array
+	bool getBit(int bit) const = delete;
+	void setBit(int bit, bool value) = delete;
 };
 
+typedef LynxArrayT<int8_t, LynxLib::eInt8Array_RW, LynxLib::eInt8Array_RO> LynxArray_i8;
+typedef LynxArrayT<uint8_t, LynxLib::eUint8Array_RW, LynxLib::eUint8Array_RO> LynxArray_u8;
+typedef LynxArrayT<int16_t, LynxLib::eInt16Array_RW, LynxLib::eInt16Array_RO> LynxArray_i16;
+typedef LynxArrayT<uint16_t, LynxLib::eUint16Array_RW, LynxLib::eUint16Array_RO> LynxArray_u16;
+typedef LynxArrayT<int32_t, LynxLib::eInt32Array_RW, LynxLib::eInt32Array_RO> LynxArray_i32;
+typedef LynxArrayT<uint32_t, LynxLib::eUint32Array_RW, LynxLib::eUint32Array_RO> LynxArray_u32;
+typedef LynxArrayT<int64_t, LynxLib::eInt64Array_RW, LynxLib::eInt64Array_RO> LynxArray_i64;
+typedef LynxArrayT<uint64_t, LynxLib::eUint64Array_RW, LynxLib::eUint64Array_RO> LynxArray_u64;
+typedef LynxArrayT<float, LynxLib::eFloatArray_RW, LynxLib::eFloatArray_RO> LynxArray_float;
+typedef LynxArrayT<double, LynxLib::eDoubleArray_RW, LynxLib::eDoubleArray_RO> LynxArray_double;
+
 // extern LynxManager Lynx;
 
 #endif // !LYNX_STRUCTURE_H
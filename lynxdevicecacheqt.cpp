@@ -0,0 +1,219 @@
+#include "lynxdevicecacheqt.h"
+
+// ------------------------ File layout ------------------------
+// -------------------------------------------------------------
+// |    Description   |    Size    |     Index    |  Contents  |
+// -------------------------------------------------------------
+// |       Magic      |     4      |    0 -> 3    |   "LYDC"   |
+// |  Format version  |     1      |       4      |     1      |
+// |      Entries     |     -      |     5 ->     |     -      |
+// -------------------------------------------------------------
+//
+// ------------------------ Entry ------------------------------
+// -------------------------------------------------------------
+// |    Description   |    Size    |     Index    |  Contents  |
+// -------------------------------------------------------------
+// |    Schema hash   |     4      |    0 -> 3    |     -      |
+// |    Data length   |     2      |    4 -> 5    | 0 -> 65535 |
+// |    Device data   |     a      |  6 -> a + 5  |     -      |
+// -------------------------------------------------------------
+// a = Data length
+// The device data has the same layout as in an eDeviceInfo datagram (see LynxLib::deviceInfoToArray())
+
+#define LYNX_CACHE_MAGIC "LYDC"
+#define LYNX_CACHE_VERSION char(1)
+#define LYNX_CACHE_HEADER_BYTES 5
+#define LYNX_CACHE_ENTRY_BYTES 6
+
+static uint32_t readUint32(const char * data)
+{
+    uint32_t value = 0;
+
+    for (int i = 0; i < 4; i++)
+        value |= ((uint32_t(data[i]) & 0xff) << (8 * i));
+
+    return value;
+}
+
+static int readLength(const char * data)
+{
+    return ((int(data[0]) & 0xff) | ((int(data[1]) & 0xff) << 8));
+}
+
+LynxDeviceCacheQt::LynxDeviceCacheQt(const QString & fileName) :
+    _file(fileName),
+    _data(nullptr),
+    _size(0)
+{
+}
+
+bool LynxDeviceCacheQt::open(const QString & fileName)
+{
+    this->close();
+    _file.setFileName(fileName);
+
+    return this->open();
+}
+
+bool LynxDeviceCacheQt::open()
+{
+    this->close();
+
+    if (!_file.open(QIODevice::ReadWrite))
+        return false;
+
+    if (_file.size() < LYNX_CACHE_HEADER_BYTES)
+    {
+        // New (or unusable) file, start over
+        _file.resize(0);
+        _file.write(LYNX_CACHE_MAGIC, 4);
+        _file.putChar(LYNX_CACHE_VERSION);
+        _file.flush();
+    }
+
+    if (!this->map())
+    {
+        this->close();
+        return false;
+    }
+
+    if ((memcmp(_data, LYNX_CACHE_MAGIC, 4) != 0) || (_data[4] != LYNX_CACHE_VERSION))
+    {
+        this->close();
+        return false;
+    }
+
+    qint64 offset = LYNX_CACHE_HEADER_BYTES;
+
+    while ((offset + LYNX_CACHE_ENTRY_BYTES) <= _size)
+    {
+        qint64 next = offset + LYNX_CACHE_ENTRY_BYTES + readLength(&_data[offset + 4]);
+
+        if (next > _size)
+            break;
+
+        _entries.insert(readUint32(&_data[offset]), offset);
+        offset = next;
+    }
+
+    if (offset < _size)
+    {
+        // Drop an entry that was only partially written
+        this->unmap();
+        _file.resize(offset);
+
+        if (!this->map())
+        {
+            this->close();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void LynxDeviceCacheQt::close()
+{
+    this->unmap();
+    _entries.clear();
+
+    if (_file.isOpen())
+        _file.close();
+}
+
+bool LynxDeviceCacheQt::find(uint32_t schemaHash, LynxDeviceInfo & deviceInfo) const
+{
+    QHash<uint32_t, qint64>::const_iterator entry = _entries.constFind(schemaHash);
+
+    if (entry == _entries.constEnd())
+        return false;
+
+    const char * data = &_data[entry.value()];
+
+    return (LynxLib::deviceInfoFromArray(&data[LYNX_CACHE_ENTRY_BYTES], readLength(&data[4]), deviceInfo) >= 0);
+}
+
+bool LynxDeviceCacheQt::insert(const LynxDeviceInfo & deviceInfo)
+{
+    if (!_file.isOpen())
+        return false;
+
+    uint32_t schemaHash = LynxLib::schemaHash(deviceInfo, true);
+
+    if (_entries.contains(schemaHash))
+        return true;
+
+    int dataLength = LynxLib::deviceInfoSize(deviceInfo);
+
+    if (dataLength > 0xffff)
+        return false;
+
+    LynxByteArray buffer(dataLength + LYNX_CACHE_ENTRY_BYTES);
+    LynxLib::expandInt(int32_t(schemaHash), buffer);
+    buffer.append(char(dataLength & 0xff));
+    buffer.append(char((dataLength >> 8) & 0xff));
+    LynxLib::deviceInfoToArray(deviceInfo, buffer);
+
+    qint64 offset = _size;
+
+    this->unmap();
+
+    bool written = (_file.seek(offset) && (_file.write(buffer.data(), buffer.count()) == buffer.count()) && _file.flush());
+
+    if (!written)
+        _file.resize(offset);
+
+    if (!this->map())
+    {
+        this->close();
+        return false;
+    }
+
+    if (written)
+        _entries.insert(schemaHash, offset);
+
+    return written;
+}
+
+bool LynxDeviceCacheQt::restore(uint32_t schemaHash, LynxManager & lynx, LynxList<LynxDynamicId> * dynamicIds, bool enableReadOnly) const
+{
+    LynxDeviceInfo deviceInfo;
+
+    if (!this->find(schemaHash, deviceInfo))
+        return false;
+
+    if (dynamicIds != nullptr)
+        dynamicIds->reserve(deviceInfo.structs.count());
+
+    bool success = true;
+
+    for (int i = 0; i < deviceInfo.structs.count(); i++)
+    {
+        LynxDynamicId dynamicId = lynx.addStructure(deviceInfo.structs.at(i), enableReadOnly);
+
+        if (dynamicId.structLynxId.structIndex < 0)
+            success = false;
+
+        if (dynamicIds != nullptr)
+            dynamicIds->append(dynamicId);
+    }
+
+    return success;
+}
+
+bool LynxDeviceCacheQt::map()
+{
+    _size = _file.size();
+    _data = reinterpret_cast<const char *>(_file.map(0, _size));
+
+    return (_data != nullptr);
+}
+
+void LynxDeviceCacheQt::unmap()
+{
+    if (_data != nullptr)
+        _file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(_data)));
+
+    _data = nullptr;
+    _size = 0;
+}
@@ -0,0 +1,49 @@
+#ifndef LYNXDEVICECACHEQT_H
+#define LYNXDEVICECACHEQT_H
+
+#include "lynxstructure.h"
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <cstring>
+
+// Host side cache of device info, stored in a binary file and read through a memory map.
+// Entries are keyed by LynxLib::schemaHash(deviceInfo, true), so a reconnecting device can be
+// recognized with LynxIoDevice::requestSchemaHash() instead of a full scan.
+class LynxDeviceCacheQt
+{
+public:
+    explicit LynxDeviceCacheQt(const QString & fileName = QString());
+    ~LynxDeviceCacheQt() { this->close(); }
+
+    /// Opens (or creates) the cache file and maps it into memory
+    bool open();
+    bool open(const QString & fileName);
+    void close();
+    bool isOpen() const { return _file.isOpen(); }
+
+    int count() const { return _entries.count(); }
+    bool contains(uint32_t schemaHash) const { return _entries.contains(schemaHash); }
+
+    /// Decodes the cached device info with the given schema hash. Returns false if it is not in the cache.
+    bool find(uint32_t schemaHash, LynxDeviceInfo & deviceInfo) const;
+    /// Appends deviceInfo to the cache file. Returns false if it could not be written.
+    bool insert(const LynxDeviceInfo & deviceInfo);
+
+    /// Adds the structures of a cached device to lynx, the same way as adding the structs of a received LynxDeviceInfo.
+    /// If dynamicIds is provided it is filled with the ids of the added structures.
+    bool restore(uint32_t schemaHash, LynxManager & lynx, LynxList<LynxDynamicId> * dynamicIds = nullptr, bool enableReadOnly = false) const;
+
+private:
+    bool map();
+    void unmap();
+
+    QFile _file;
+    const char * _data;
+    qint64 _size;
+
+    // Schema hash -> file offset of the entry
+    QHash<uint32_t, qint64> _entries;
+};
+
+#endif // LYNXDEVICECACHEQT_H
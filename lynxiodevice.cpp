@@ -3,7 +3,12 @@
 LynxIoDevice::LynxIoDevice(LynxManager * const lynx) :
     _state(LynxLib::eFindHeader),
     _open(false),
-    _lynx(lynx)
+    _lynx(lynx),
+	_capabilities(LynxLib::eCapabilityBatch),
+	_remoteCapabilities(LynxLib::eNoCapabilities),
+	_remoteSchemaReceived(false),
+	_remoteSchemaDescriptions(false),
+	_remoteSchemaHash(0)
 {
 }
 
@@ -97,6 +102,45 @@ const LynxInfo & LynxIoDevice::update()
             case LynxLib::eChangeDeviceId:
                 _state = LynxLib::eGetDeviceId;
                 break;
+			case LynxLib::eDeltaDatagram:
+				_state = LynxLib::eGetDeltaInfo;
+				break;
+			case LynxLib::eBatchDatagram:
+				_state = LynxLib::eGetBatchInfo;
+				break;
+			case LynxLib::eCapabilities:
+				_state = LynxLib::eGetCapabilities;
+				break;
+			case LynxLib::eRangeDatagram:
+				_state = LynxLib::eGetRangeInfo;
+				break;
+			case LynxLib::ePullRange:
+				_state = LynxLib::eGetPullRange;
+				break;
+			case LynxLib::eStartPeriodicRange:
+				_state = LynxLib::eGetPeriodicStartRange;
+				break;
+			case LynxLib::eStopPeriodicRange:
+				_state = LynxLib::eGetPeriodicStopRange;
+				break;
+			case LynxLib::eDefineView:
+				_state = LynxLib::eGetViewDefinition;
+				break;
+			case LynxLib::eViewDatagram:
+				_state = LynxLib::eGetViewInfo;
+				break;
+			case LynxLib::ePullView:
+				_state = LynxLib::eGetPullView;
+				break;
+			case LynxLib::eStartPeriodicView:
+				_state = LynxLib::eGetPeriodicStartView;
+				break;
+			case LynxLib::eStopPeriodicView:
+				_state = LynxLib::eGetPeriodicStopView;
+				break;
+			case LynxLib::eSchemaHash:
+				_state = LynxLib::eGetSchemaHash;
+				break;
 			default:
 				_updateInfo.state = LynxLib::eInvalidInternalId;
 				_state = LynxLib::eFindHeader;
@@ -366,7 +410,12 @@ const LynxInfo & LynxIoDevice::update()
 				return _updateInfo;
 			}
 
-			this->readDeviceInfo();
+			if (!this->readDeviceInfo())
+			{
+				_updateInfo.state = LynxLib::eWrongDataLength;
+				_state = LynxLib::eFindHeader;
+				return _updateInfo;
+			}
 
 			_updateInfo.deviceId = _deviceInfo.deviceId;
 			_updateInfo.state = LynxLib::eNewDeviceInfoReceived;
@@ -374,251 +423,756 @@ const LynxInfo & LynxIoDevice::update()
 		}
 	}
 
-    if (_state == LynxLib::eGetInfo)
+	if (_state == LynxLib::eGetDeltaInfo)
 	{
-        if (this->bytesAvailable() >= 3)
+		// ------------------------ Frame ------------------------------
+		// -------------------------------------------------------------
+		// |    Description   |    Size    |     Index    |  Contents  |
+		// -------------------------------------------------------------
+		// |   Static header  |     1      |       0      |    'A'     |
+		// |    Datagram Id   |     1      |       1      |    255     |
+		// | Internal data id |     1      |       2      |     7      |
+		// |     Struct Id    |     1      |       3      |  0 -> 254  |
+		// |    Data length   |     2      |     4 -> 5   | 0 -> 65535 |
+		// |     Device Id    |     1      |       6      |  0 -> 255  |
+		// |  Bitmap + Data   |     a      | 7 -> (n - 2) |     -      |
+		// |     Checksum     |     1      |    (n - 1)   |  0 -> 255  |
+		// -------------------------------------------------------------
+		// a = Data length
+
+		if (this->bytesAvailable() >= 4)
 		{
-            this->read();
-            _updateInfo.lynxId.variableIndex = int(_readBuffer.at(2)) - 1;
-            if(_updateInfo.lynxId.variableIndex > _lynx->structVariableCount(_updateInfo.lynxId.structIndex))
-            {
-                _state = LynxLib::eFindHeader;
-                _updateInfo.state = LynxLib::eVariableIndexOutOfBounds;
-                return _updateInfo;
-            }
+			this->read(4);
 
-            this->read();
-            _updateInfo.dataLength = int(_readBuffer.at(3));
-            //if(_updateInfo.dataLength != _lynx->transferSize(_updateInfo.lynxId))
-            //{
-            //    _state = eFindHeader;
-            //    _updateInfo.state = eWrongDataLength;
-            //    return _updateInfo;
-            //}
+			_updateInfo.lynxId.structIndex = _lynx->findId(_readBuffer.at(3));
+			_updateInfo.lynxId.variableIndex = -1;
 
-            this->read();
-            _updateInfo.deviceId = _readBuffer.at(4);
+			if (_updateInfo.lynxId.structIndex < 0)
+			{
+				_updateInfo.state = LynxLib::eStructIdNotFound;
+				_state = LynxLib::eFindHeader;
+				return _updateInfo;
+			}
+
+			int low = (int(_readBuffer.at(4)) & 0xff);
+			int high = ((int(_readBuffer.at(5)) << 8) & 0xff00);
+
+			_updateInfo.dataLength = (low | high);
+			_updateInfo.deviceId = _readBuffer.at(6);
 
 			_transferLength = _updateInfo.dataLength + LYNX_CHECKSUM_BYTES;
 
-            _state = LynxLib::eGetData;
+			_state = LynxLib::eGetData;
 		}
 	}
 
-    if (_state == LynxLib::eGetData)
+	if (_state == LynxLib::eGetBatchInfo)
 	{
-		if (this->bytesAvailable() >= _transferLength)
+		// ------------------------ Frame ------------------------------
+		// -------------------------------------------------------------
+		// |    Description   |    Size    |     Index    |  Contents  |
+		// -------------------------------------------------------------
+		// |   Static header  |     1      |       0      |    'A'     |
+		// |    Datagram Id   |     1      |       1      |    255     |
+		// | Internal data id |     1      |       2      |     8      |
+		// |    Data length   |     2      |     3 -> 4   | 0 -> 65535 |
+		// |     Device Id    |     1      |       5      |  0 -> 255  |
+		// |      Entries     |     a      | 6 -> (n - 2) |     -      |
+		// |     Checksum     |     1      |    (n - 1)   |  0 -> 255  |
+		// -------------------------------------------------------------
+		// a = Data length
+
+		if (this->bytesAvailable() >= 3)
 		{
-			_readBuffer.resize(_readBuffer.count() + _transferLength);
+			this->read(3);
 
-            read(_transferLength);
+			int low = (int(_readBuffer.at(3)) & 0xff);
+			int high = ((int(_readBuffer.at(4)) << 8) & 0xff00);
 
-            _lynx->fromArray(_readBuffer, _updateInfo);
+			_updateInfo.dataLength = (low | high);
+			_updateInfo.deviceId = _readBuffer.at(5);
 
-			_state = LynxLib::eFindHeader;
+			_transferLength = _updateInfo.dataLength + LYNX_CHECKSUM_BYTES;
+
+			_state = LynxLib::eGetData;
 		}
 	}
 
-	return _updateInfo;
-}
+	if (_state == LynxLib::eGetCapabilities)
+	{
+		// ---------------------------- Frame --------------------------------
+		// -------------------------------------------------------------------
+		// |    Description    |    Size    |     Index    |    Contents     |
+		// -------------------------------------------------------------------
+		// |   Static header   |     1      |       0      |      'A'        |
+		// |    Datagram Id    |     1      |       1      |      255        |
+		// | Internal data id  |     1      |       2      |       9         |
+		// |   Capabilities    |     1      |       3      |    0 -> 255     |
+		// |   Reply request   |     1      |       4      |     0 -> 1      |
+		// |     Checksum      |     1      |       5      |    0 -> 255     |
+		// -------------------------------------------------------------------
 
-LynxLib::E_LynxState LynxIoDevice::periodicUpdate()
-{
-	LynxLib::E_LynxState returnState = LynxLib::eNoChange;
+		if (this->bytesAvailable() >= 3)
+		{
+			this->read(3);
 
-	_currentTime = this->getMillis();
+			if (!LynxLib::checkChecksum(_readBuffer))
+			{
+				_updateInfo.state = LynxLib::eWrongChecksum;
+				_state = LynxLib::eFindHeader;
+				return _updateInfo;
+			}
 
-	int overtime;
-	for (int i = 0; i < _periodicTransmits.count(); i++)
-	{
-		overtime = (_currentTime - _periodicTransmits.at(i).previousTimeStamp) - _periodicTransmits.at(i).timeInterval;
-		if (overtime >= 0)
-		{
-			_periodicTransmits[i].previousTimeStamp = _currentTime - overtime;
-			LynxLib::E_LynxState tmpState = this->send(LynxId(_periodicTransmits.at(i)));
-			if (returnState < LynxLib::eErrors)
-				returnState = tmpState;
+			_remoteCapabilities = _readBuffer.at(3);
+
+			if (_readBuffer.at(4) != 0)
+				this->sendCapabilities(false);
+
+			_updateInfo.state = LynxLib::eCapabilitiesReceived;
+			_state = LynxLib::eFindHeader;
+			return _updateInfo;
 		}
 	}
 
-	return returnState;
-}
+	if (_state == LynxLib::eGetSchemaHash)
+	{
+		// ---------------------------- Frame --------------------------------
+		// -------------------------------------------------------------------
+		// |    Description    |    Size    |     Index    |    Contents     |
+		// -------------------------------------------------------------------
+		// |   Static header   |     1      |       0      |      'A'        |
+		// |    Datagram Id    |     1      |       1      |      255        |
+		// | Internal data id  |     1      |       2      |      19         |
+		// |     Device Id     |     1      |       3      |    1 -> 255     |
+		// |       Flags       |     1      |       4      |     0 -> 3      |
+		// |    Schema hash    |     4      |     5 -> 8   | 0 -> (2^32 - 1) |
+		// |     Checksum      |     1      |       9      |    0 -> 255     |
+		// -------------------------------------------------------------------
+		// Flags: bit 0 = descriptions included in the hash, bit 1 = reply request
 
-LynxLib::E_LynxState LynxIoDevice::send(const LynxId & lynxId)
-{
-	LynxLib::E_LynxState state = _lynx->toArray(_writeBuffer, lynxId);
-	
-	if (state != LynxLib::eDataCopiedToBuffer)
-		return state;
+		if (this->bytesAvailable() >= 7)
+		{
+			this->read(7);
 
-    this->write();
+			if (!LynxLib::checkChecksum(_readBuffer))
+			{
+				_updateInfo.state = LynxLib::eWrongChecksum;
+				_state = LynxLib::eFindHeader;
+				return _updateInfo;
+			}
 
-	return state;
-}
+			char flags = _readBuffer.at(4);
 
-int LynxIoDevice::sendDeviceInfo()
-{
-	LynxDeviceInfo deviceInfo;
+			_remoteSchemaReceived = true;
+			_remoteSchemaDescriptions = ((flags & 0x01) != 0);
+			_remoteSchemaHash = uint32_t(LynxLib::combineInt(_readBuffer, 5));
 
-	_lynx->getInfo(deviceInfo);
+			if ((flags & 0x02) != 0)
+				this->sendSchemaHash(_remoteSchemaDescriptions, false);
 
-	int dataLength = deviceInfo.description.count();		// Description (max 255)
-	dataLength += deviceInfo.lynxVersion.count();			// Version (max 255 (should not happen though, but you never know...))
-	dataLength += 4;										// Device Id + Description length + Version length + struct count;
-		
-	for (int i = 0; i < deviceInfo.structs.count(); i++) 
-	{
-		dataLength += deviceInfo.structs.at(i).description.count();			// Description (max 255)
-		dataLength += 3;													// structId + variableCount + Description length
-			
-		for (int j = 0; j < deviceInfo.structs.at(i).variables.count(); j++)
-		{																	
-			dataLength += deviceInfo.structs.at(i).variables.at(j).description.count();	// Description (max 255)
-			dataLength += 3;															// index + data type + desc. length
+			_updateInfo.deviceId = _readBuffer.at(3);
+			_updateInfo.state = LynxLib::eSchemaHashReceived;
+			_state = LynxLib::eFindHeader;
+			return _updateInfo;
 		}
 	}
 
-	_writeBuffer.reserve(dataLength + LYNX_HEADER_BYTES + LYNX_CHECKSUM_BYTES);
+	if ((_state == LynxLib::eGetPullRange) || (_state == LynxLib::eGetPeriodicStartRange) || (_state == LynxLib::eGetPeriodicStopRange))
+	{
+		// ---------------------------- Frame --------------------------------
+		// -------------------------------------------------------------------
+		// |    Description    |    Size    |     Index    |    Contents     |
+		// -------------------------------------------------------------------
+		// |   Static header   |     1      |       0      |      'A'        |
+		// |    Datagram Id    |     1      |       1      |      255        |
+		// | Internal data id  |     1      |       2      |  11 / 12 / 13   |
+		// |     Struct Id     |     1      |       3      |    0 -> 254     |
+		// |    Start index    |     1      |       4      |    0 -> 255     |
+		// |  Variable count   |     1      |       5      |    1 -> 255     |
+		// | Periodic interval |     4      |     6 -> 9   | 0 -> (2^32 - 1) |  (Periodic start only)
+		// |     Checksum      |     1      |    (n - 1)   |    0 -> 255     |
+		// -------------------------------------------------------------------
 
-	// ---------------------------- Header --------------------------------------
+		int frameBytes = 4;
+		if (_state == LynxLib::eGetPeriodicStartRange)
+			frameBytes += 4;
 
-	// ------------------------ Frame ----------------------------
-	// -----------------------------------------------------------
-	// |  Description   |    Size    |     Index    |  Contents  |
-	// -----------------------------------------------------------
-	// | Static header  |     1      |       0      |    'A'     |
-	// |   Struct Id    |     1      |       1      |    255     |
-	// |  Int. data id  |     1      |       2      |     1      |
-	// |  Data length   |     2      |     3 -> 4   | 0 -> 65535 |
-	// |  Device Data   |     a      | 5 -> (n - 2) |     -      |
-	// |   Checksum     |     1      |    (n - 1)   |  0 -> 255  |
-	// -----------------------------------------------------------
-	// a = Data length
-	// n = 6 + a + 1 (total length)
+		if (this->bytesAvailable() >= frameBytes)
+		{
+			this->read(frameBytes);
 
-	_writeBuffer.append(LYNX_STATIC_HEADER);					// lynx header
-	_writeBuffer.append(LYNX_INTERNALS_HEADER);					// Internal datagram
-	_writeBuffer.append(char(LynxLib::eDeviceInfo));	// Internal type
-	int low = dataLength & 0xff;
-	int high = (dataLength >> 8) & 0xff;
-	_writeBuffer.append(char(low));				// Data Length (Low)
-	_writeBuffer.append(char(high));		// Data Length (High)
+			LynxLib::E_SerialState request = _state;
+			_state = LynxLib::eFindHeader;
 
-	// ---------------------------- Device --------------------------------------
-
-	// ------------------------ Device Data -------------------------
-	// --------------------------------------------------------------
-	// |    Description    | Size |        Index       |  Contents  |
-	// --------------------------------------------------------------
-	// |   Device Id       |  1   |          5         |  0 -> 255  |
-	// | Device desc. len  |  1   |          6         |  0 -> 255  |
-	// |   Device desc.    |  b   |    7 -> (B - 1)    |     -      |
-	// |   Version len     |  1   |          B         |  0 -> 255  |
-	// |     Version       |  c   | (B + 1) -> (C - 1) |     -      |
-	// |   Struct count    |  1   |          C         |  0 -> 255  |
-	// |   Struct data     |  -   | (C + 1) -> (n - 2) |     -      |
-	// --------------------------------------------------------------
-	// b = Device desc. len
-	// B = 7 + b
-	// c = Version len
-	// C = c + d
-
-	_writeBuffer.append(deviceInfo.deviceId);					// Device id
-	_writeBuffer.append(char(deviceInfo.description.count()));	// Device desc. length
-	// deviceInfo.description.toByteArray(_writeBuffer);			// Device desc.
-	_writeBuffer.fromCharArray(deviceInfo.description.toCharArray(), deviceInfo.description.count());
-	_writeBuffer.append(char(deviceInfo.lynxVersion.count()));	// Version length
-	// deviceInfo.lynxVersion.toByteArray(_writeBuffer);			// Version
-	_writeBuffer.fromCharArray(deviceInfo.lynxVersion.toCharArray(), deviceInfo.lynxVersion.count());
-	_writeBuffer.append(char(deviceInfo.structCount));			// Struct count
-		
-	// ---------------------------- Structs --------------------------------------
-	for (int i = 0; i < deviceInfo.structs.count(); i++)
-	{
-		// ------------------------ Struct Data -------------------------
-		// --------------------------------------------------------------
-		// |    Description    | Size |        Index       |  Contents  |
-		// --------------------------------------------------------------
-		// |    Struct Id      |  1   |          k         |  0 -> 255  |
-		// | Struct desc. len  |  1   |        k + 1       |  0 -> 255  |
-		// |   Struct desc.    |  d   | (k + 2) -> (D - 1) |     -      |
-		// |  Variable count   |  1   |       (D + 1)      |  0 -> 255  |
-		// |  Variable data    |  -   |    (D + 2) -> E    |     -      |
-		// --------------------------------------------------------------
-		// k = C + 1 + i * struct size (variable) | where i is the struct indexer
-		// d = Struct desc. len
-		// D = k + 2 + d
-
-		_writeBuffer.append(deviceInfo.structs.at(i).structId);						// Struct id
-		_writeBuffer.append(char(deviceInfo.structs.at(i).description.count()));	// Struct desc. length
-		// deviceInfo.structs.at(i).description.toByteArray(_writeBuffer);				// Struct desc.
-		_writeBuffer.fromCharArray(deviceInfo.structs.at(i).description.toCharArray(), deviceInfo.structs.at(i).description.count());
-		_writeBuffer.append(char(deviceInfo.structs.at(i).variableCount));			// Variable count
-		
-		// ---------------------------- Variables --------------------------------------
-		for (int j = 0; j < deviceInfo.structs.at(i).variables.count(); j++)
-		{
-			// ---------------------- Variable Data -------------------------
-			// --------------------------------------------------------------
-			// |    Description    | Size |        Index       |  Contents  |
-			// --------------------------------------------------------------
-			// |  Variable Index   |  1   |          p         |  0 -> 255  |
-			// |   Var desc. len   |  1   |        p + 1       |  0 -> 255  |
-			// |     Var desc.     |  e   | (p + 2) -> (E - 1) |     -      |
-			// |  Variable Type    |  1   |          E         |  0 -> 255  |
-			// --------------------------------------------------------------
-			// p = D + 2 + j * variable size (variable) | where j is the variable indexer
-			// e = Var desc. len
-			// E = p + 2 + e
-
-			_writeBuffer.append(deviceInfo.structs.at(i).variables.at(j).index);						// Variable index
-			_writeBuffer.append(char(deviceInfo.structs.at(i).variables.at(j).description.count()));	// Variable desc. length
-			// deviceInfo.structs.at(i).variables.at(j).description.toByteArray(_writeBuffer);				// Variable desc.
-			_writeBuffer.fromCharArray(deviceInfo.structs.at(i).variables.at(j).description.toCharArray(), deviceInfo.structs.at(i).variables.at(j).description.count());
-			_writeBuffer.append(char(deviceInfo.structs.at(i).variables.at(j).dataType));				// Variable type
+			if (!LynxLib::checkChecksum(_readBuffer))
+			{
+				_updateInfo.state = LynxLib::eWrongChecksum;
+				return _updateInfo;
+			}
+
+			_updateInfo.lynxId.structIndex = _lynx->findId(_readBuffer.at(3));
+			_updateInfo.lynxId.variableIndex = int(_readBuffer.at(4)) & 0xff;
+			_updateInfo.variableCount = int(_readBuffer.at(5)) & 0xff;
+
+			if (_updateInfo.lynxId.structIndex < 0)
+			{
+				_updateInfo.state = LynxLib::eStructIdNotFound;
+				return _updateInfo;
+			}
+			else if ((_updateInfo.variableCount < 1) || 
+				((_updateInfo.lynxId.variableIndex + _updateInfo.variableCount) > _lynx->structVariableCount(_updateInfo.lynxId.structIndex)))
+			{
+				_updateInfo.state = LynxLib::eVariableIndexOutOfBounds;
+				return _updateInfo;
+			}
+
+			if (request == LynxLib::eGetPullRange)
+			{
+				this->send(_updateInfo.lynxId, _updateInfo.variableCount);
+				_updateInfo.state = LynxLib::ePullRequestReceived;
+			}
+			else if (request == LynxLib::eGetPeriodicStartRange)
+			{
+				this->periodicStart(_updateInfo.lynxId, uint32_t(LynxLib::combineInt(_readBuffer, 6)), LynxLib::ePeriodicAll, _updateInfo.variableCount);
+				_updateInfo.state = LynxLib::ePeriodicTransmitStart;
+			}
+			else
+			{
+				this->periodicStop(_updateInfo.lynxId, _updateInfo.variableCount);
+				_updateInfo.state = LynxLib::ePeriodicTransmitStop;
+			}
+
+			return _updateInfo;
 		}
 	}
 
-	// -------------------------- Checksum -----------------------------------
-	//char checksum = 0;
-
-	//for (int i = 0; i < _writeBuffer.count(); i++)
-	//{
-	//	checksum += _writeBuffer.at(i);
-	//}
+	if ((_state == LynxLib::eGetPullView) || (_state == LynxLib::eGetPeriodicStartView) || (_state == LynxLib::eGetPeriodicStopView))
+	{
+		// ---------------------------- Frame --------------------------------
+		// -------------------------------------------------------------------
+		// |    Description    |    Size    |     Index    |    Contents     |
+		// -------------------------------------------------------------------
+		// |   Static header   |     1      |       0      |      'A'        |
+		// |    Datagram Id    |     1      |       1      |      255        |
+		// | Internal data id  |     1      |       2      |  16 / 17 / 18   |
+		// |      View Id      |     1      |       3      |    0 -> 255     |
+		// | Periodic interval |     4      |     4 -> 7   | 0 -> (2^32 - 1) |  (Periodic start only)
+		// |     Checksum      |     1      |    (n - 1)   |    0 -> 255     |
+		// -------------------------------------------------------------------
 
-	//_writeBuffer.append(checksum);
+		int frameBytes = 2;
+		if (_state == LynxLib::eGetPeriodicStartView)
+			frameBytes += 4;
 
-	LynxLib::addChecksum(_writeBuffer);
+		if (this->bytesAvailable() >= frameBytes)
+		{
+			this->read(frameBytes);
 
-	this->write();
+			LynxLib::E_SerialState request = _state;
+			_state = LynxLib::eFindHeader;
 
-	return _writeBuffer.count();
-}
+			if (!LynxLib::checkChecksum(_readBuffer))
+			{
+				_updateInfo.state = LynxLib::eWrongChecksum;
+				return _updateInfo;
+			}
 
-void LynxIoDevice::scan()
-{
-	// ------------------------ Frame ------------------------------
-	// -------------------------------------------------------------
-	// |    Description   |    Size    |     Index    |  Contents  |
-	// -------------------------------------------------------------
-	// |   Static header  |     1      |       0      |    'A'     |
-	// |    Datagram Id   |     1      |       1      |    255     |
-	// | Internal data id |     1      |       2      |     2      |
-	// |     Checksum     |     1      |       3      |  0 -> 255  |
-	// -------------------------------------------------------------
+			_updateInfo.lynxViewId = _lynx->findView(_readBuffer.at(3));
 
-	_writeBuffer.reserve(4);
-	_writeBuffer.append(LYNX_STATIC_HEADER);
-	_writeBuffer.append(LYNX_INTERNALS_HEADER);
-	_writeBuffer.append(LynxLib::E_LynxInternals::eScan);
-	LynxLib::addChecksum(_writeBuffer);
+			if (_updateInfo.lynxViewId.viewIndex < 0)
+			{
+				_updateInfo.state = LynxLib::eViewIdNotFound;
+				return _updateInfo;
+			}
 
-	this->write();
-}
+			if (request == LynxLib::eGetPullView)
+			{
+				this->send(_updateInfo.lynxViewId);
+				_updateInfo.state = LynxLib::ePullRequestReceived;
+			}
+			else if (request == LynxLib::eGetPeriodicStartView)
+			{
+				this->periodicStart(_updateInfo.lynxViewId, uint32_t(LynxLib::combineInt(_readBuffer, 4)));
+				_updateInfo.state = LynxLib::ePeriodicTransmitStart;
+			}
+			else
+			{
+				this->periodicStop(_updateInfo.lynxViewId);
+				_updateInfo.state = LynxLib::ePeriodicTransmitStop;
+			}
 
-void LynxIoDevice::pullDatagram(const LynxId & lynxId)
+			return _updateInfo;
+		}
+	}
+
+	if (_state == LynxLib::eGetViewDefinition)
+	{
+		// See defineRemoteView() for the frame layout
+
+		if (this->bytesAvailable() >= 2)
+		{
+			this->read(2);
+
+			int low = (int(_readBuffer.at(3)) & 0xff);
+			int high = ((int(_readBuffer.at(4)) << 8) & 0xff00);
+
+			_updateInfo.dataLength = (low | high);
+
+			_transferLength = _updateInfo.dataLength + LYNX_CHECKSUM_BYTES;
+
+			_state = LynxLib::eGetViewDefinitionData;
+		}
+	}
+
+	if (_state == LynxLib::eGetViewDefinitionData)
+	{
+		if (this->bytesAvailable() >= _transferLength)
+		{
+			_readBuffer.resize(_readBuffer.count() + _transferLength);
+
+			this->read(_transferLength);
+
+			_state = LynxLib::eFindHeader;
+
+			if (!LynxLib::checkChecksum(_readBuffer))
+			{
+				_updateInfo.state = LynxLib::eWrongChecksum;
+				return _updateInfo;
+			}
+
+			this->readViewDefinition();
+
+			return _updateInfo;
+		}
+	}
+
+	if (_state == LynxLib::eGetViewInfo)
+	{
+		// See LynxManager::readView() for the frame layout
+
+		if (this->bytesAvailable() >= 4)
+		{
+			this->read(4);
+
+			int low = (int(_readBuffer.at(4)) & 0xff);
+			int high = ((int(_readBuffer.at(5)) << 8) & 0xff00);
+
+			_updateInfo.dataLength = (low | high);
+			_updateInfo.deviceId = _readBuffer.at(6);
+
+			_transferLength = _updateInfo.dataLength + LYNX_CHECKSUM_BYTES;
+
+			_state = LynxLib::eGetData;
+		}
+	}
+
+	if (_state == LynxLib::eGetRangeInfo)
+	{
+		// ------------------------ Frame ------------------------------
+		// -------------------------------------------------------------
+		// |    Description   |    Size    |     Index    |  Contents  |
+		// -------------------------------------------------------------
+		// |   Static header  |     1      |       0      |    'A'     |
+		// |    Datagram Id   |     1      |       1      |    255     |
+		// | Internal data id |     1      |       2      |     10     |
+		// |     Struct Id    |     1      |       3      |  0 -> 254  |
+		// |    Start index   |     1      |       4      |  0 -> 255  |
+		// |  Variable count  |     1      |       5      |  1 -> 255  |
+		// |    Data length   |     2      |     6 -> 7   | 0 -> 65535 |
+		// |     Device Id    |     1      |       8      |  0 -> 255  |
+		// |       Data       |     a      | 9 -> (n - 2) |     -      |
+		// |     Checksum     |     1      |    (n - 1)   |  0 -> 255  |
+		// -------------------------------------------------------------
+		// a = Data length
+
+		if (this->bytesAvailable() >= 6)
+		{
+			this->read(6);
+
+			_updateInfo.lynxId.structIndex = _lynx->findId(_readBuffer.at(3));
+
+			if (_updateInfo.lynxId.structIndex < 0)
+			{
+				_updateInfo.state = LynxLib::eStructIdNotFound;
+				_state = LynxLib::eFindHeader;
+				return _updateInfo;
+			}
+
+			int low = (int(_readBuffer.at(6)) & 0xff);
+			int high = ((int(_readBuffer.at(7)) << 8) & 0xff00);
+
+			_updateInfo.dataLength = (low | high);
+			_updateInfo.deviceId = _readBuffer.at(8);
+
+			_transferLength = _updateInfo.dataLength + LYNX_CHECKSUM_BYTES;
+
+			_state = LynxLib::eGetData;
+		}
+	}
+
+    if (_state == LynxLib::eGetInfo)
+	{
+        if (this->bytesAvailable() >= 3)
+		{
+            this->read();
+            _updateInfo.lynxId.variableIndex = int(_readBuffer.at(2)) - 1;
+            if(_updateInfo.lynxId.variableIndex > _lynx->structVariableCount(_updateInfo.lynxId.structIndex))
+            {
+                _state = LynxLib::eFindHeader;
+                _updateInfo.state = LynxLib::eVariableIndexOutOfBounds;
+                return _updateInfo;
+            }
+
+            this->read();
+            _updateInfo.dataLength = int(_readBuffer.at(3));
+            //if(_updateInfo.dataLength != _lynx->transferSize(_updateInfo.lynxId))
+            //{
+            //    _state = eFindHeader;
+            //    _updateInfo.state = eWrongDataLength;
+            //    return _updateInfo;
+            //}
+
+            this->read();
+            _updateInfo.deviceId = _readBuffer.at(4);
+
+			_transferLength = _updateInfo.dataLength + LYNX_CHECKSUM_BYTES;
+
+            _state = LynxLib::eGetData;
+		}
+	}
+
+    if (_state == LynxLib::eGetData)
+	{
+		if (this->bytesAvailable() >= _transferLength)
+		{
+			_readBuffer.resize(_readBuffer.count() + _transferLength);
+
+            read(_transferLength);
+
+			_batchContents.clear();
+            _lynx->fromArray(_readBuffer, _updateInfo, &_batchContents);
+
+			_state = LynxLib::eFindHeader;
+		}
+	}
+
+	return _updateInfo;
+}
+
+LynxLib::E_LynxState LynxIoDevice::periodicUpdate()
+{
+	LynxLib::E_LynxState returnState = LynxLib::eNoChange;
+
+	_currentTime = this->getMillis();
+
+	// If the remote can receive batch datagrams, all the targets that are due are collected and sent in one frame
+	bool batch = ((_remoteCapabilities & LynxLib::eCapabilityBatch) != 0);
+	int batchLength = 0;
+
+	_batchIds.clear();
+
+	int overtime;
+	for (int i = 0; i < _periodicTransmits.count(); i++)
+	{
+		overtime = (_currentTime - _periodicTransmits.at(i).previousTimeStamp) - _periodicTransmits.at(i).timeInterval;
+		if (overtime >= 0)
+		{
+			_periodicTransmits[i].previousTimeStamp = _currentTime - overtime;
+
+			LynxId lynxId = LynxId(_periodicTransmits.at(i));
+			LynxLib::E_LynxState tmpState = LynxLib::eNoChange;
+
+			if (_periodicTransmits.at(i).lynxViewId.viewIndex >= 0) // View
+			{
+				tmpState = this->send(_periodicTransmits.at(i).lynxViewId);
+
+				if (returnState < LynxLib::eErrors)
+					returnState = tmpState;
+
+				continue;
+			}
+
+			int entryLength = _lynx->transferSize(lynxId);
+
+			if (_periodicTransmits.at(i).variableCount > 0) // Range
+			{
+				if (_periodicTransmits.at(i).mode == LynxLib::ePeriodicChanged)
+					tmpState = this->sendChanged(lynxId, _periodicTransmits.at(i).variableCount, _periodicTransmits[i].sentStamp);
+				else
+					tmpState = this->send(lynxId, _periodicTransmits.at(i).variableCount);
+			}
+			else if (_periodicTransmits.at(i).mode == LynxLib::ePeriodicChanged)
+			{
+				tmpState = this->sendChanged(lynxId, _periodicTransmits[i].sentStamp);
+			}
+			else if (batch && (entryLength > 0) && (entryLength <= 255)) // The entry length of a batch is a single byte
+			{
+				entryLength += LYNX_BATCH_ENTRY_BYTES;
+
+				if ((batchLength + entryLength) > 0xffff)
+				{
+					tmpState = this->sendBatch();
+					batchLength = 0;
+				}
+
+				_batchIds.append(lynxId);
+				batchLength += entryLength;
+			}
+			else
+			{
+				tmpState = this->send(lynxId);
+			}
+
+			if ((returnState < LynxLib::eErrors) && (tmpState != LynxLib::eNoChange))
+				returnState = tmpState;
+		}
+	}
+
+	if (_batchIds.count() > 0)
+	{
+		LynxLib::E_LynxState tmpState = this->sendBatch();
+
+		if (returnState < LynxLib::eErrors)
+			returnState = tmpState;
+	}
+
+	return returnState;
+}
+
+LynxLib::E_LynxState LynxIoDevice::sendBatch()
+{
+	LynxLib::E_LynxState state;
+
+	// A single target is smaller as a regular datagram
+	if (_batchIds.count() == 1)
+		state = this->send(_batchIds.at(0));
+	else
+		state = this->send(_batchIds);
+
+	_batchIds.clear();
+
+	return state;
+}
+
+LynxLib::E_LynxState LynxIoDevice::send(const LynxId & lynxId)
+{
+	LynxLib::E_LynxState state = _lynx->toArray(_writeBuffer, lynxId);
+	
+	if (state != LynxLib::eDataCopiedToBuffer)
+		return state;
+
+    this->write();
+
+	return state;
+}
+
+LynxLib::E_LynxState LynxIoDevice::send(const LynxId & lynxId, const LynxByteArray & variableMask)
+{
+	LynxLib::E_LynxState state = _lynx->toArray(_writeBuffer, lynxId, variableMask);
+
+	if (state != LynxLib::eDataCopiedToBuffer)
+		return state;
+
+	this->write();
+
+	return state;
+}
+
+LynxLib::E_LynxState LynxIoDevice::send(const LynxList<LynxId> & lynxIds)
+{
+	LynxLib::E_LynxState state = _lynx->toArray(_writeBuffer, lynxIds);
+
+	if (state != LynxLib::eDataCopiedToBuffer)
+		return state;
+
+	this->write();
+
+	return state;
+}
+
+LynxLib::E_LynxState LynxIoDevice::send(const LynxId & lynxId, int variableCount)
+{
+	LynxLib::E_LynxState state = _lynx->toArray(_writeBuffer, lynxId, variableCount);
+
+	if (state != LynxLib::eDataCopiedToBuffer)
+		return state;
+
+	this->write();
+
+	return state;
+}
+
+LynxLib::E_LynxState LynxIoDevice::send(const LynxViewId & lynxViewId)
+{
+	LynxLib::E_LynxState state = _lynx->toArray(_writeBuffer, lynxViewId);
+
+	if (state != LynxLib::eDataCopiedToBuffer)
+		return state;
+
+	this->write();
+
+	return state;
+}
+
+LynxLib::E_LynxState LynxIoDevice::sendChanged(const LynxId & lynxId, int variableCount, uint32_t & sentStamp)
+{
+	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= _lynx->count()))
+		return LynxLib::eNoChange;
+
+	uint32_t stamp;
+	LynxLib::E_LynxState state;
+
+	{
+		// The stamp is taken before encoding, so a change made meanwhile is sent again next time rather than lost.
+		// The lock is released before writing, so other threads don't wait for the port.
+		LynxReadLocker locker(_lynx->structure(lynxId));
+
+		if (!_lynx->changedSince(lynxId, sentStamp, variableCount))
+			return LynxLib::eNoChange;
+
+		stamp = _lynx->changeStamp(lynxId);
+		state = _lynx->toArray(_writeBuffer, lynxId, variableCount);
+	}
+
+	if (state != LynxLib::eDataCopiedToBuffer)
+		return state;
+
+	this->write();
+	sentStamp = stamp;
+
+	return state;
+}
+
+LynxLib::E_LynxState LynxIoDevice::sendChanged(const LynxId & lynxId, uint32_t & sentStamp)
+{
+	if ((lynxId.structIndex < 0) || (lynxId.structIndex >= _lynx->count()))
+		return LynxLib::eNoChange;
+
+	uint32_t stamp;
+	LynxLib::E_LynxState state;
+
+	{
+		// See sendChanged(lynxId, variableCount, sentStamp)
+		LynxReadLocker locker(_lynx->structure(lynxId));
+
+		if (!_lynx->changedSince(lynxId, sentStamp))
+			return LynxLib::eNoChange;
+
+		stamp = _lynx->changeStamp(lynxId);
+
+		if ((lynxId.variableIndex >= 0) || (sentStamp == 0)) // Single variable, or the first transmit
+		{
+			state = _lynx->toArray(_writeBuffer, lynxId);
+		}
+		else
+		{
+			// Whole struct. Send a single variable if only one has changed, otherwise send
+			// a delta datagram unless the whole struct is smaller on the wire.
+			int changedCount = _lynx->changedSince(lynxId, sentStamp, _changedMask);
+
+			if (changedCount == 1)
+			{
+				int changedIndex = 0;
+				while (!LynxLib::bitmapGet(_changedMask, changedIndex))
+				{
+					changedIndex++;
+				}
+
+				state = _lynx->toArray(_writeBuffer, LynxId(lynxId.structIndex, changedIndex));
+			}
+			else
+			{
+				int deltaSize = LYNX_DELTA_HEADER_BYTES + _changedMask.count() + _lynx->transferSize(lynxId, _changedMask);
+				int fullSize = LYNX_HEADER_BYTES + _lynx->transferSize(lynxId);
+
+				if (deltaSize < fullSize)
+					state = _lynx->toArray(_writeBuffer, lynxId, _changedMask);
+				else
+					state = _lynx->toArray(_writeBuffer, lynxId);
+			}
+		}
+	}
+
+	if (state != LynxLib::eDataCopiedToBuffer)
+		return state;
+
+	this->write();
+	sentStamp = stamp;
+
+	return state;
+}
+
+int LynxIoDevice::sendDeviceInfo()
+{
+	LynxDeviceInfo deviceInfo;
+
+	_lynx->getInfo(deviceInfo);
+
+	int dataLength = LynxLib::deviceInfoSize(deviceInfo);
+
+	_writeBuffer.reserve(dataLength + LYNX_HEADER_BYTES + LYNX_CHECKSUM_BYTES);
+
+	// ------------------------ Frame ----------------------------
+	// -----------------------------------------------------------
+	// |  Description   |    Size    |     Index    |  Contents  |
+	// -----------------------------------------------------------
+	// | Static header  |     1      |       0      |    'A'     |
+	// |   Struct Id    |     1      |       1      |    255     |
+	// |  Int. data id  |     1      |       2      |     1      |
+	// |  Data length   |     2      |     3 -> 4   | 0 -> 65535 |
+	// |  Device Data   |     a      | 5 -> (n - 2) |     -      |
+	// |   Checksum     |     1      |    (n - 1)   |  0 -> 255  |
+	// -----------------------------------------------------------
+	// a = Data length
+	// n = 6 + a + 1 (total length)
+	// See LynxLib::deviceInfoToArray() for the device data
+
+	_writeBuffer.append(LYNX_STATIC_HEADER);					// lynx header
+	_writeBuffer.append(LYNX_INTERNALS_HEADER);					// Internal datagram
+	_writeBuffer.append(char(LynxLib::eDeviceInfo));	// Internal type
+	int low = dataLength & 0xff;
+	int high = (dataLength >> 8) & 0xff;
+	_writeBuffer.append(char(low));				// Data Length (Low)
+	_writeBuffer.append(char(high));		// Data Length (High)
+
+	LynxLib::deviceInfoToArray(deviceInfo, _writeBuffer);
+
+	LynxLib::addChecksum(_writeBuffer);
+
+	this->write();
+
+	return _writeBuffer.count();
+}
+
+void LynxIoDevice::scan()
+{
+	// ------------------------ Frame ------------------------------
+	// -------------------------------------------------------------
+	// |    Description   |    Size    |     Index    |  Contents  |
+	// -------------------------------------------------------------
+	// |   Static header  |     1      |       0      |    'A'     |
+	// |    Datagram Id   |     1      |       1      |    255     |
+	// | Internal data id |     1      |       2      |     2      |
+	// |     Checksum     |     1      |       3      |  0 -> 255  |
+	// -------------------------------------------------------------
+
+	_writeBuffer.reserve(4);
+	_writeBuffer.append(LYNX_STATIC_HEADER);
+	_writeBuffer.append(LYNX_INTERNALS_HEADER);
+	_writeBuffer.append(LynxLib::E_LynxInternals::eScan);
+	LynxLib::addChecksum(_writeBuffer);
+
+	this->write();
+}
+
+void LynxIoDevice::pullDatagram(const LynxId & lynxId, int variableCount)
 {
+	if (variableCount > 0)
+	{
+		this->pullRange(lynxId, variableCount);
+		return;
+	}
+
 	// ------------------------ Frame ------------------------------
 	// -------------------------------------------------------------
 	// |    Description   |    Size    |     Index    |  Contents  |
@@ -642,26 +1196,57 @@ void LynxIoDevice::pullDatagram(const LynxId & lynxId)
 	this->write();
 }
 	
-void LynxIoDevice::periodicStart(const LynxId & lynxId, uint32_t interval)
+void LynxIoDevice::pullRange(const LynxId & lynxId, int variableCount)
+{
+	// ------------------------ Frame ------------------------------
+	// -------------------------------------------------------------
+	// |    Description   |    Size    |     Index    |  Contents  |
+	// -------------------------------------------------------------
+	// |   Static header  |     1      |       0      |    'A'     |
+	// |    Datagram Id   |     1      |       1      |    255     |
+	// | Internal data id |     1      |       2      |     11     |
+	// |     Struct Id    |     1      |       3      |  0 -> 254  |
+	// |    Start index   |     1      |       4      |  0 -> 255  |
+	// |  Variable count  |     1      |       5      |  1 -> 255  |
+	// |     Checksum     |     1      |       6      |  0 -> 255  |
+	// -------------------------------------------------------------
+
+	_writeBuffer.reserve(7);
+	_writeBuffer.append(LYNX_STATIC_HEADER);
+	_writeBuffer.append(LYNX_INTERNALS_HEADER);
+	_writeBuffer.append(LynxLib::E_LynxInternals::ePullRange);
+	_writeBuffer.append(_lynx->structId(lynxId));
+	_writeBuffer.append(char(lynxId.variableIndex));
+	_writeBuffer.append(char(variableCount));
+	LynxLib::addChecksum(_writeBuffer);
+
+	this->write();
+}
+
+void LynxIoDevice::periodicStart(const LynxId & lynxId, uint32_t interval, LynxLib::E_LynxPeriodicMode mode, int variableCount)
 {
 	for (int i = 0; i < _periodicTransmits.count(); i++)
 	{
-		if (LynxId(_periodicTransmits.at(i)) == lynxId)
+		if ((LynxId(_periodicTransmits.at(i)) == lynxId) && (_periodicTransmits.at(i).variableCount == variableCount) && 
+			(_periodicTransmits.at(i).lynxViewId.viewIndex < 0))
 		{
 			_periodicTransmits[i].timeInterval = interval;
+			_periodicTransmits[i].mode = mode;
+			_periodicTransmits[i].sentStamp = 0; // The receiver's state is unknown, so the next transmit contains everything
 			return;
 		}
 	}
 
-	_periodicTransmits.append(LynxPeriodicTransmit(lynxId, interval, this->getMillis()));
+	_periodicTransmits.append(LynxPeriodicTransmit(lynxId, interval, this->getMillis(), mode, variableCount));
 	return;
 }
 
-void LynxIoDevice::periodicStop(const LynxId & lynxId)
+void LynxIoDevice::periodicStop(const LynxId & lynxId, int variableCount)
 {
 	for (int i = 0; i < _periodicTransmits.count(); i++)
 	{
-		if (LynxId(_periodicTransmits.at(i)) == lynxId)
+		if ((LynxId(_periodicTransmits.at(i)) == lynxId) && (_periodicTransmits.at(i).variableCount == variableCount) &&
+			(_periodicTransmits.at(i).lynxViewId.viewIndex < 0))
 		{
 			_periodicTransmits.remove(i);
 			return;
@@ -669,8 +1254,14 @@ void LynxIoDevice::periodicStop(const LynxId & lynxId)
 	}
 }
 
-void LynxIoDevice::remotePeriodicStart(const LynxId & lynxId, uint32_t interval)
+void LynxIoDevice::remotePeriodicStart(const LynxId & lynxId, uint32_t interval, int variableCount)
 {
+	if (variableCount > 0)
+	{
+		this->remotePeriodicStartRange(lynxId, interval, variableCount);
+		return;
+	}
+
 	// ---------------------------- Frame --------------------------------
 	// -------------------------------------------------------------------
 	// |    Description    |    Size    |     Index    |    Contents     |
@@ -696,8 +1287,14 @@ void LynxIoDevice::remotePeriodicStart(const LynxId & lynxId, uint32_t interval)
 	this->write();
 }
 
-void LynxIoDevice::remotePeriodicStop(const LynxId & lynxId)
+void LynxIoDevice::remotePeriodicStop(const LynxId & lynxId, int variableCount)
 {
+	if (variableCount > 0)
+	{
+		this->remotePeriodicStopRange(lynxId, variableCount);
+		return;
+	}
+
 	// ---------------------------- Frame --------------------------------
 	// -------------------------------------------------------------------
 	// |    Description    |    Size    |     Index    |    Contents     |
@@ -721,6 +1318,249 @@ void LynxIoDevice::remotePeriodicStop(const LynxId & lynxId)
 	this->write();
 }
 
+void LynxIoDevice::remotePeriodicStartRange(const LynxId & lynxId, uint32_t interval, int variableCount)
+{
+	// ---------------------------- Frame --------------------------------
+	// -------------------------------------------------------------------
+	// |    Description    |    Size    |     Index    |    Contents     |
+	// -------------------------------------------------------------------
+	// |   Static header   |     1      |       0      |      'A'        |
+	// |    Datagram Id    |     1      |       1      |      255        |
+	// | Internal data id  |     1      |       2      |       12        |
+	// |     Struct Id     |     1      |       3      |    0 -> 254     |
+	// |    Start index    |     1      |       4      |    0 -> 255     |
+	// |  Variable count   |     1      |       5      |    1 -> 255     |
+	// | Periodic interval |     4      |     6 -> 9   | 0 -> (2^32 - 1) |
+	// |     Checksum      |     1      |      10      |    0 -> 255     |
+	// -------------------------------------------------------------------
+
+	_writeBuffer.reserve(11);
+	_writeBuffer.append(LYNX_STATIC_HEADER);
+	_writeBuffer.append(LYNX_INTERNALS_HEADER);
+	_writeBuffer.append(LynxLib::E_LynxInternals::eStartPeriodicRange);
+	_writeBuffer.append(_lynx->structId(lynxId));
+	_writeBuffer.append(char(lynxId.variableIndex));
+	_writeBuffer.append(char(variableCount));
+	LynxLib::expandInt(int32_t(interval), _writeBuffer);
+	LynxLib::addChecksum(_writeBuffer);
+
+	this->write();
+}
+
+void LynxIoDevice::remotePeriodicStopRange(const LynxId & lynxId, int variableCount)
+{
+	// ---------------------------- Frame --------------------------------
+	// -------------------------------------------------------------------
+	// |    Description    |    Size    |     Index    |    Contents     |
+	// -------------------------------------------------------------------
+	// |   Static header   |     1      |       0      |      'A'        |
+	// |    Datagram Id    |     1      |       1      |      255        |
+	// | Internal data id  |     1      |       2      |       13        |
+	// |     Struct Id     |     1      |       3      |    0 -> 254     |
+	// |    Start index    |     1      |       4      |    0 -> 255     |
+	// |  Variable count   |     1      |       5      |    1 -> 255     |
+	// |     Checksum      |     1      |       6      |    0 -> 255     |
+	// -------------------------------------------------------------------
+
+	_writeBuffer.reserve(7);
+	_writeBuffer.append(LYNX_STATIC_HEADER);
+	_writeBuffer.append(LYNX_INTERNALS_HEADER);
+	_writeBuffer.append(LynxLib::E_LynxInternals::eStopPeriodicRange);
+	_writeBuffer.append(_lynx->structId(lynxId));
+	_writeBuffer.append(char(lynxId.variableIndex));
+	_writeBuffer.append(char(variableCount));
+	LynxLib::addChecksum(_writeBuffer);
+
+	this->write();
+}
+
+void LynxIoDevice::pullDatagram(const LynxViewId & lynxViewId)
+{
+	this->sendViewRequest(LynxLib::ePullView, lynxViewId);
+}
+
+void LynxIoDevice::periodicStart(const LynxViewId & lynxViewId, uint32_t interval)
+{
+	for (int i = 0; i < _periodicTransmits.count(); i++)
+	{
+		if (_periodicTransmits.at(i).lynxViewId == lynxViewId)
+		{
+			_periodicTransmits[i].timeInterval = interval;
+			return;
+		}
+	}
+
+	_periodicTransmits.append(LynxPeriodicTransmit(lynxViewId, interval, this->getMillis()));
+}
+
+void LynxIoDevice::periodicStop(const LynxViewId & lynxViewId)
+{
+	for (int i = 0; i < _periodicTransmits.count(); i++)
+	{
+		if (_periodicTransmits.at(i).lynxViewId == lynxViewId)
+		{
+			_periodicTransmits.remove(i);
+			return;
+		}
+	}
+}
+
+void LynxIoDevice::remotePeriodicStart(const LynxViewId & lynxViewId, uint32_t interval)
+{
+	this->sendViewRequest(LynxLib::eStartPeriodicView, lynxViewId, interval);
+}
+
+void LynxIoDevice::remotePeriodicStop(const LynxViewId & lynxViewId)
+{
+	this->sendViewRequest(LynxLib::eStopPeriodicView, lynxViewId);
+}
+
+void LynxIoDevice::sendViewRequest(LynxLib::E_LynxInternals request, const LynxViewId & lynxViewId, uint32_t interval)
+{
+	// ---------------------------- Frame --------------------------------
+	// -------------------------------------------------------------------
+	// |    Description    |    Size    |     Index    |    Contents     |
+	// -------------------------------------------------------------------
+	// |   Static header   |     1      |       0      |      'A'        |
+	// |    Datagram Id    |     1      |       1      |      255        |
+	// | Internal data id  |     1      |       2      |  16 / 17 / 18   |
+	// |      View Id      |     1      |       3      |    0 -> 255     |
+	// | Periodic interval |     4      |     4 -> 7   | 0 -> (2^32 - 1) |  (Periodic start only)
+	// |     Checksum      |     1      |    (n - 1)   |    0 -> 255     |
+	// -------------------------------------------------------------------
+
+	if ((lynxViewId.viewIndex < 0) || (lynxViewId.viewIndex >= _lynx->viewCount()))
+		return;
+
+	_writeBuffer.reserve(9);
+	_writeBuffer.append(LYNX_STATIC_HEADER);
+	_writeBuffer.append(LYNX_INTERNALS_HEADER);
+	_writeBuffer.append(char(request));
+	_writeBuffer.append(_lynx->view(lynxViewId).viewId);
+	if (request == LynxLib::eStartPeriodicView)
+		LynxLib::expandInt(int32_t(interval), _writeBuffer);
+	LynxLib::addChecksum(_writeBuffer);
+
+	this->write();
+}
+
+void LynxIoDevice::defineRemoteView(const LynxViewId & lynxViewId)
+{
+	// ------------------------ Frame ------------------------------
+	// -------------------------------------------------------------
+	// |    Description   |    Size    |     Index    |  Contents  |
+	// -------------------------------------------------------------
+	// |   Static header  |     1      |       0      |    'A'     |
+	// |    Datagram Id   |     1      |       1      |    255     |
+	// | Internal data id |     1      |       2      |     14     |
+	// |    Data length   |     2      |     3 -> 4   | 0 -> 65535 |
+	// |      View Id     |     1      |       5      |  0 -> 255  |
+	// |   View name len  |     1      |       6      |  0 -> 255  |
+	// |     View name    |     b      | 7 -> (B - 1) |     -      |
+	// |   Target count   |     1      |       B      |  0 -> 255  |
+	// |      Targets     |   2 * c    |  (B + 1) ->  |     -      |
+	// |     Checksum     |     1      |    (n - 1)   |  0 -> 255  |
+	// -------------------------------------------------------------
+	// b = View name len
+	// B = 7 + b
+	// c = Target count. Every target is a struct id followed by variable index + 1 (0 means the whole struct)
+
+	if ((lynxViewId.viewIndex < 0) || (lynxViewId.viewIndex >= _lynx->viewCount()))
+		return;
+
+	const LynxView & view = _lynx->view(lynxViewId);
+
+	int nameLength = view.name.count();
+	if (nameLength > 255)
+		nameLength = 255;
+
+	int dataLength = 3 + nameLength + 2 * view.lynxIds.count();	// View id + name length + target count + name + targets
+
+	_writeBuffer.reserve(dataLength + LYNX_HEADER_BYTES + LYNX_CHECKSUM_BYTES);
+	_writeBuffer.append(LYNX_STATIC_HEADER);
+	_writeBuffer.append(LYNX_INTERNALS_HEADER);
+	_writeBuffer.append(char(LynxLib::eDefineView));
+	_writeBuffer.append(char(dataLength & 0xff));
+	_writeBuffer.append(char((dataLength >> 8) & 0xff));
+	_writeBuffer.append(view.viewId);
+	_writeBuffer.append(char(nameLength));
+	_writeBuffer.append(view.name.toCharArray(), nameLength);
+	_writeBuffer.append(char(view.lynxIds.count()));
+
+	for (int i = 0; i < view.lynxIds.count(); i++)
+	{
+		_writeBuffer.append(_lynx->structId(view.lynxIds.at(i)));
+		_writeBuffer.append(char(view.lynxIds.at(i).variableIndex + 1));
+	}
+
+	LynxLib::addChecksum(_writeBuffer);
+
+	this->write();
+}
+
+void LynxIoDevice::readViewDefinition()
+{
+	// See defineRemoteView() for the frame layout
+
+	int readIndex = LYNX_HEADER_BYTES;
+	int dataEnd = LYNX_HEADER_BYTES + _updateInfo.dataLength;
+
+	// View id and name length
+	if ((readIndex + 2) > dataEnd)
+	{
+		_updateInfo.state = LynxLib::eWrongDataLength;
+		return;
+	}
+
+	char viewId = _readBuffer.at(readIndex);
+	readIndex++;
+	int nameLength = int(_readBuffer.at(readIndex)) & 0xff;
+	readIndex++;
+
+	// Name and target count
+	if ((readIndex + nameLength + 1) > dataEnd)
+	{
+		_updateInfo.state = LynxLib::eWrongDataLength;
+		return;
+	}
+
+	LynxString name;
+	name.append(&_readBuffer.at(readIndex), nameLength);
+	readIndex += nameLength;
+
+	int targetCount = int(_readBuffer.at(readIndex)) & 0xff;
+	readIndex++;
+
+	if ((readIndex + 2 * targetCount) != dataEnd)
+	{
+		_updateInfo.state = LynxLib::eWrongDataLength;
+		return;
+	}
+
+	LynxList<LynxId> lynxIds(targetCount);
+
+	for (int i = 0; i < targetCount; i++)
+	{
+		LynxId lynxId(_lynx->findId(_readBuffer.at(readIndex)), (int(_readBuffer.at(readIndex + 1)) & 0xff) - 1);
+		readIndex += 2;
+
+		if (lynxId.structIndex < 0)
+		{
+			_updateInfo.state = LynxLib::eStructIdNotFound;
+			return;
+		}
+
+		lynxIds.append(lynxId);
+	}
+
+	_updateInfo.lynxViewId = _lynx->addView(viewId, lynxIds, name);
+
+	if (_updateInfo.lynxViewId.viewIndex < 0)
+		_updateInfo.state = LynxLib::eVariableIndexOutOfBounds;
+	else
+		_updateInfo.state = LynxLib::eViewDefined;
+}
+
 void LynxIoDevice::changeRemoteDeviceId(char deviceId)
 {
     if (deviceId == 0) // invalid deviceId
@@ -747,6 +1587,83 @@ void LynxIoDevice::changeRemoteDeviceId(char deviceId)
     this->write();
 }
 
+void LynxIoDevice::negotiateCapabilities()
+{
+	this->sendCapabilities(true);
+}
+
+void LynxIoDevice::sendCapabilities(bool requestReply)
+{
+	// ---------------------------- Frame --------------------------------
+	// -------------------------------------------------------------------
+	// |    Description    |    Size    |     Index    |    Contents     |
+	// -------------------------------------------------------------------
+	// |   Static header   |     1      |       0      |      'A'        |
+	// |    Datagram Id    |     1      |       1      |      255        |
+	// | Internal data id  |     1      |       2      |       9         |
+	// |   Capabilities    |     1      |       3      |    0 -> 255     |
+	// |   Reply request   |     1      |       4      |     0 -> 1      |
+	// |     Checksum      |     1      |       5      |    0 -> 255     |
+	// -------------------------------------------------------------------
+
+	_writeBuffer.reserve(6);
+	_writeBuffer.append(LYNX_STATIC_HEADER);
+	_writeBuffer.append(LYNX_INTERNALS_HEADER);
+	_writeBuffer.append(LynxLib::E_LynxInternals::eCapabilities);
+	_writeBuffer.append(_capabilities);
+	_writeBuffer.append(char(requestReply ? 1 : 0));
+	LynxLib::addChecksum(_writeBuffer);
+
+	this->write();
+}
+
+void LynxIoDevice::requestSchemaHash(bool includeDescriptions)
+{
+	this->sendSchemaHash(includeDescriptions, true);
+}
+
+void LynxIoDevice::sendSchemaHash(bool includeDescriptions, bool requestReply)
+{
+	// ---------------------------- Frame --------------------------------
+	// -------------------------------------------------------------------
+	// |    Description    |    Size    |     Index    |    Contents     |
+	// -------------------------------------------------------------------
+	// |   Static header   |     1      |       0      |      'A'        |
+	// |    Datagram Id    |     1      |       1      |      255        |
+	// | Internal data id  |     1      |       2      |      19         |
+	// |     Device Id     |     1      |       3      |    1 -> 255     |
+	// |       Flags       |     1      |       4      |     0 -> 3      |
+	// |    Schema hash    |     4      |     5 -> 8   | 0 -> (2^32 - 1) |
+	// |     Checksum      |     1      |       9      |    0 -> 255     |
+	// -------------------------------------------------------------------
+	// Flags: bit 0 = descriptions included in the hash, bit 1 = reply request
+
+	char flags = 0;
+	if (includeDescriptions)
+		flags |= 0x01;
+	if (requestReply)
+		flags |= 0x02;
+
+	_writeBuffer.reserve(10);
+	_writeBuffer.append(LYNX_STATIC_HEADER);
+	_writeBuffer.append(LYNX_INTERNALS_HEADER);
+	_writeBuffer.append(LynxLib::E_LynxInternals::eSchemaHash);
+	_writeBuffer.append(_lynx->deviceId());
+	_writeBuffer.append(flags);
+	LynxLib::expandInt(int32_t(_lynx->schemaHash(includeDescriptions)), _writeBuffer);
+	LynxLib::addChecksum(_writeBuffer);
+
+	this->write();
+}
+
+bool LynxIoDevice::remoteSchemaMatches(const LynxDeviceInfo & deviceInfo) const
+{
+	if (!_remoteSchemaReceived)
+		return false;
+
+	return (LynxLib::schemaHash(deviceInfo, _remoteSchemaDescriptions) == _remoteSchemaHash);
+}
+
 LynxDeviceInfo LynxIoDevice::lynxDeviceInfo()
 {
 	LynxDeviceInfo temp = _deviceInfo;
@@ -756,100 +1673,10 @@ LynxDeviceInfo LynxIoDevice::lynxDeviceInfo()
 	return temp;
 }
 
-void LynxIoDevice::readDeviceInfo()
-{
-	// ------------------------ Device Data -------------------------
-	// --------------------------------------------------------------
-	// |    Description    | Size |        Index       |  Contents  |
-	// --------------------------------------------------------------
-	// |   Device Id       |  1   |          5         |  0 -> 255  |
-	// | Device desc. len  |  1   |          6         |  0 -> 255  |
-	// |   Device desc.    |  b   |    7 -> (B - 1)    |     -      |
-	// |   Version len     |  1   |          B         |  0 -> 255  |
-	// |     Version       |  c   | (B + 1) -> (C - 1) |     -      |
-	// |   Struct count    |  1   |          C         |  0 -> 255  |
-	// |   Struct data     |  -   | (C + 1) -> (n - 2) |     -      |
-	// --------------------------------------------------------------
-	// b = Device desc. len
-	// B = 7 + b
-	// c = Version len
-	// C = c + d
-
-	int readIndex = LYNX_HEADER_BYTES;
-	_deviceInfo.deviceId = _readBuffer.at(readIndex);
-	readIndex++;
-	int readLength = int(_readBuffer.at(readIndex)) & 0xff;
-	readIndex++;
-	_deviceInfo.description.clear();
-	_deviceInfo.description.append(&_readBuffer.at(readIndex), readLength);
-	readIndex += readLength;
-	readLength = int(_readBuffer.at(readIndex)) & 0xff;
-	readIndex++;
-	_deviceInfo.lynxVersion.clear();
-	_deviceInfo.lynxVersion.append(&_readBuffer.at(readIndex), readLength);
-	readIndex += readLength;
-	_deviceInfo.structCount = int(_readBuffer.at(readIndex)) & 0xff;
-	readIndex++;
+bool LynxIoDevice::readDeviceInfo()
+{
+	// The device data starts after the header and ends before the checksum
+	int dataLength = _readBuffer.count() - LYNX_HEADER_BYTES - LYNX_CHECKSUM_BYTES;
 
-	_deviceInfo.structs.reserve(_deviceInfo.structCount);
-
-	for (int i = 0; i < _deviceInfo.structCount; i++)
-	{
-		// ------------------------ Struct Data -------------------------
-		// --------------------------------------------------------------
-		// |    Description    | Size |        Index       |  Contents  |
-		// --------------------------------------------------------------
-		// |    Struct Id      |  1   |          k         |  0 -> 255  |
-		// | Struct desc. len  |  1   |        k + 1       |  0 -> 255  |
-		// |   Struct desc.    |  d   | (k + 2) -> (D - 1) |     -      |
-		// |  Variable count   |  1   |       (D + 1)      |  0 -> 255  |
-		// |  Variable data    |  -   |    (D + 2) -> E    |     -      |
-		// --------------------------------------------------------------
-		// k = C + 1 + i * struct size (variable) | where i is the struct indexer
-		// d = Struct desc. len
-		// D = k + 2 + d
-
-		_deviceInfo.structs.append();
-
-		_deviceInfo.structs[i].structId = _readBuffer.at(readIndex);
-		readIndex++;
-		readLength = int(_readBuffer.at(readIndex)) & 0xff;
-		readIndex++;
-		_deviceInfo.structs[i].description.clear();
-		_deviceInfo.structs[i].description.append(&_readBuffer.at(readIndex), readLength);
-		readIndex += readLength;
-		_deviceInfo.structs[i].variableCount = int(_readBuffer.at(readIndex)) & 0xff;
-		readIndex++;
-
-		_deviceInfo.structs[i].variables.reserve(_deviceInfo.structs.at(i).variableCount);
-
-		for (int j = 0; j < _deviceInfo.structs.at(i).variableCount; j++)
-		{
-			// ---------------------- Variable Data -------------------------
-			// --------------------------------------------------------------
-			// |    Description    | Size |        Index       |  Contents  |
-			// --------------------------------------------------------------
-			// |  Variable Index   |  1   |          p         |  0 -> 255  |
-			// |   Var desc. len   |  1   |        p + 1       |  0 -> 255  |
-			// |     Var desc.     |  e   | (p + 2) -> (E - 1) |     -      |
-			// |  Variable Type    |  1   |          E         |  0 -> 255  |
-			// --------------------------------------------------------------
-			// p = D + 2 + j * variable size (variable) | where j is the variable indexer
-			// e = Var desc. len
-			// E = p + 2 + e
-
-			_deviceInfo.structs[i].variables.append();
-
-			_deviceInfo.structs[i].variables[j].index = _readBuffer.at(readIndex);
-			readIndex++;
-			readLength = int(_readBuffer.at(readIndex)) & 0xff;
-			readIndex++;
-			_deviceInfo.structs[i].variables[j].description.clear();
-			_deviceInfo.structs[i].variables[j].description.append(&_readBuffer.at(readIndex), readLength);
-			readIndex += readLength;
-			_deviceInfo.structs[i].variables[j].dataType = LynxLib::E_LynxDataType(int(_readBuffer.at(readIndex)) & 0xff);
-			readIndex++;
-		}
-	}
+	return (LynxLib::deviceInfoFromArray(&_readBuffer.at(LYNX_HEADER_BYTES), dataLength, _deviceInfo) >= 0);
 }
-
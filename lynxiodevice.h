@@ -18,22 +18,65 @@ namespace LynxLib
         eGetDeviceId,
 		eGetDeviceInfo,
 		eGetDeviceData,
+		eGetDeltaInfo,
+		eGetBatchInfo,
+		eGetCapabilities,
+		eGetRangeInfo,
+		eGetPullRange,
+		eGetPeriodicStartRange,
+		eGetPeriodicStopRange,
+		eGetViewDefinition,
+		eGetViewDefinitionData,
+		eGetViewInfo,
+		eGetPullView,
+		eGetPeriodicStartView,
+		eGetPeriodicStopView,
+		eGetSchemaHash,
 		eGetData
 	};
+
+	enum E_LynxPeriodicMode
+	{
+		ePeriodicAll = 0,	// Transmit on every interval
+		ePeriodicChanged	// Only transmit the variables that have changed since the last transmit
+	};
+
+	enum E_LynxCapabilities
+	{
+		eNoCapabilities = 0x00,
+		eCapabilityBatch = 0x01	// Can receive batch datagrams
+	};
 }
 
 struct LynxPeriodicTransmit : public LynxId
 {
-    LynxPeriodicTransmit() : LynxId(), timeInterval(0), previousTimeStamp(0) {}
+    LynxPeriodicTransmit() : LynxId(), timeInterval(0), previousTimeStamp(0), mode(LynxLib::ePeriodicAll), variableCount(0), sentStamp(0) {}
 
-	LynxPeriodicTransmit(const LynxId & lynxId, uint32_t _timeInterval, uint32_t _previousTimeStamp) : 
+	LynxPeriodicTransmit(const LynxId & lynxId, uint32_t _timeInterval, uint32_t _previousTimeStamp, LynxLib::E_LynxPeriodicMode _mode = LynxLib::ePeriodicAll, int _variableCount = 0) : 
 		LynxId(lynxId), 
 		timeInterval(_timeInterval),
-		previousTimeStamp(_previousTimeStamp)
+		previousTimeStamp(_previousTimeStamp),
+		mode(_mode),
+		variableCount(_variableCount),
+		sentStamp(0)
     {}
 
+	LynxPeriodicTransmit(const LynxViewId & _lynxViewId, uint32_t _timeInterval, uint32_t _previousTimeStamp) :
+		LynxId(),
+		timeInterval(_timeInterval),
+		previousTimeStamp(_previousTimeStamp),
+		mode(LynxLib::ePeriodicAll),
+		variableCount(0),
+		sentStamp(0),
+		lynxViewId(_lynxViewId)
+	{}
+
 	uint32_t timeInterval; /// Time in milliseconds
 	uint32_t previousTimeStamp;
+	LynxLib::E_LynxPeriodicMode mode;
+	int variableCount; /// Number of variables from variableIndex for range transmits, 0 for regular transmits
+	uint32_t sentStamp; /// Change stamp of the last transmit in changed mode, 0 until the first one
+	LynxViewId lynxViewId; /// Valid for view transmits
 };
 
 class LynxIoDevice
@@ -52,6 +95,19 @@ public:
 	LynxLib::E_LynxState periodicUpdate();
 
     LynxLib::E_LynxState send(const LynxId & lynxId);
+	/// Sends the variables selected in variableMask (one bit per variable) as a delta datagram
+	LynxLib::E_LynxState send(const LynxId & lynxId, const LynxByteArray & variableMask);
+	/// Sends variableCount variables starting at lynxId.variableIndex as a range datagram
+	LynxLib::E_LynxState send(const LynxId & lynxId, int variableCount);
+	/// Sends all the targets of the view as one view datagram
+	LynxLib::E_LynxState send(const LynxViewId & lynxViewId);
+	/// Sends only the variables of lynxId that have changed after sentStamp, and moves sentStamp past them on success.
+	/// Every sender keeps its own stamp (0 sends everything), so the shared change flags are left alone. Returns eNoChange if nothing has changed.
+	LynxLib::E_LynxState sendChanged(const LynxId & lynxId, uint32_t & sentStamp);
+	/// Sends the range if any of its variables have changed after sentStamp
+	LynxLib::E_LynxState sendChanged(const LynxId & lynxId, int variableCount, uint32_t & sentStamp);
+	/// Sends all the targets in lynxIds in one batch datagram. The remote must support batching (see negotiateCapabilities()).
+	LynxLib::E_LynxState send(const LynxList<LynxId> & lynxIds);
     bool isOpen() const { return _open; }
 
 	int sendDeviceInfo();
@@ -62,22 +118,54 @@ public:
 	// Scan the bus for devices
 	void scan();
 	// Pull datagram from device
-	void pullDatagram(const LynxId & lynxId);
+	// If variableCount is above zero, variableCount variables starting at lynxId.variableIndex are pulled as a range
+	void pullDatagram(const LynxId & lynxId, int variableCount = 0);
+	// Pull a view datagram from device. The view must be defined on the device (see defineRemoteView())
+	void pullDatagram(const LynxViewId & lynxViewId);
 
     const LynxByteArray & readBuffer() const { return _readBuffer; }
     const LynxByteArray & writeBuffer() const { return _writeBuffer; }
 
-	/// Interval in milliseconds
-	void periodicStart(const LynxId & lynxId, uint32_t interval);
-	void periodicStop(const LynxId & lynxId);
+	/// Interval in milliseconds.
+	/// If variableCount is above zero, variableCount variables starting at lynxId.variableIndex are transmitted as a range.
+	void periodicStart(const LynxId & lynxId, uint32_t interval, LynxLib::E_LynxPeriodicMode mode = LynxLib::ePeriodicAll, int variableCount = 0);
+	void periodicStop(const LynxId & lynxId, int variableCount = 0);
 
-	void remotePeriodicStart(const LynxId & lynxId, uint32_t interval);
-	void remotePeriodicStop(const LynxId & lynxId);
+	void remotePeriodicStart(const LynxId & lynxId, uint32_t interval, int variableCount = 0);
+	void remotePeriodicStop(const LynxId & lynxId, int variableCount = 0);
+
+	/// Periodic transmit of all the targets of a view as one datagram
+	void periodicStart(const LynxViewId & lynxViewId, uint32_t interval);
+	void periodicStop(const LynxViewId & lynxViewId);
+
+	/// The view must be defined on the remote device first (see defineRemoteView())
+	void remotePeriodicStart(const LynxViewId & lynxViewId, uint32_t interval);
+	void remotePeriodicStop(const LynxViewId & lynxViewId);
+
+	/// Sends the definition of a local view to the remote device, so it can be used as a remote target
+	void defineRemoteView(const LynxViewId & lynxViewId);
 
     void changeRemoteDeviceId(char deviceId);
 
+	/// Tells the remote device what this device supports and asks for its capabilities in return.
+	/// Periodic transmits are only batched after the remote has reported that it can receive batch datagrams.
+	void negotiateCapabilities();
+	/// The capabilities reported by the remote device (see LynxLib::E_LynxCapabilities)
+	char remoteCapabilities() const { return _remoteCapabilities; }
+
+	/// The targets that were received in the last batch datagram
+	const LynxList<LynxId> & batchContents() const { return _batchContents; }
+
 	LynxDeviceInfo lynxDeviceInfo();
 
+	/// Asks the remote device for the schema hash of its structs (see LynxLib::schemaHash()).
+	/// The reply is reported as eSchemaHashReceived, and is much shorter than the full device info from scan().
+	void requestSchemaHash(bool includeDescriptions = true);
+	/// The last schema hash reported by the remote device
+	uint32_t remoteSchemaHash() const { return _remoteSchemaHash; }
+	/// Returns true if a schema hash has been received and it matches deviceInfo (typically a cached copy from an earlier scan)
+	bool remoteSchemaMatches(const LynxDeviceInfo & deviceInfo) const;
+
 protected:
 	LynxLib::E_SerialState _state;
 	LynxInfo _updateInfo;
@@ -95,15 +183,33 @@ protected:
 	/// Must return a relative timestamp in milliseconds
 	virtual uint32_t getMillis() const = 0;
 
-	void readDeviceInfo();
+	bool readDeviceInfo();
+	void sendCapabilities(bool requestReply);
+	void pullRange(const LynxId & lynxId, int variableCount);
+	void remotePeriodicStartRange(const LynxId & lynxId, uint32_t interval, int variableCount);
+	void remotePeriodicStopRange(const LynxId & lynxId, int variableCount);
+	void sendViewRequest(LynxLib::E_LynxInternals request, const LynxViewId & lynxViewId, uint32_t interval = 0);
+	void readViewDefinition();
+	void sendSchemaHash(bool includeDescriptions, bool requestReply);
+	LynxLib::E_LynxState sendBatch();
 
 	LynxDeviceInfo _deviceInfo;
 
 	LynxByteArray _readBuffer;
 	LynxByteArray _writeBuffer;
+	LynxByteArray _changedMask;	// Variables to send in sendChanged()
 
 	LynxList<LynxPeriodicTransmit> _periodicTransmits;
 	uint32_t _currentTime;
+
+	char _capabilities;
+	char _remoteCapabilities;
+	LynxList<LynxId> _batchIds;
+	LynxList<LynxId> _batchContents;
+
+	bool _remoteSchemaReceived;
+	bool _remoteSchemaDescriptions;
+	uint32_t _remoteSchemaHash;
 };
 
 #endif // !LYNX_IO_DEVICE_H
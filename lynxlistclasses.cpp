@@ -216,7 +216,7 @@ LynxString operator+(const char * const otherCharArray, const LynxString & other
 	return temp;
 }
 
-LynxString::operator const char*const() const
+LynxString::operator const char*() const
 {
 	if (_count < 1)
 		return "";
@@ -308,6 +308,19 @@ bool LynxString::compare(const LynxString & other) const
 	return (cmp == 0);
 }
 
+uint32_t LynxString::hash() const
+{
+	uint32_t temp = LYNX_HASH_SEED;
+
+	for (int i = 0; i < (_count - 1); i++)
+	{
+		temp ^= (uint32_t(_string[i]) & 0xff);
+		temp *= LYNX_HASH_PRIME;
+	}
+
+	return temp;
+}
+
 void LynxString::append(const char & other)
 {
 	if (_count < 1)
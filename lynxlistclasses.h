@@ -20,6 +20,10 @@ typedef int16_t int8_t;
 #include <string.h>
 #include <math.h>
 
+// 32 bit FNV-1a, used by LynxString::hash() and LynxLib::hashBytes()
+#define LYNX_HASH_SEED 2166136261u	// Offset basis
+#define LYNX_HASH_PRIME 16777619u
+
 //-----------------------------------------------------------------------------------------------------------
 //-------------------------------------------- LynxList -----------------------------------------------------
 //-----------------------------------------------------------------------------------------------------------
@@ -284,6 +288,15 @@ public:
 
 	const char * data() const { return _data; }
 
+	// Grows the array by size and returns a pointer to the first new byte, so it can be written in place
+	char * extend(int size)
+	{
+		this->resize(_count + size);
+		_count += size;
+
+		return (_data + (_count - size));
+	}
+
 	using LynxList::subList;
 	LynxByteArray subList(int startIndex, int endIndex)
 	{
@@ -349,6 +362,9 @@ public:
 	bool compare(const LynxString & other) const;
 	bool isEmpty() const { return (_count < 2); }
 
+	// Returns a 32 bit FNV-1a hash of the string (not including the term char)
+	uint32_t hash() const;
+
 	void append(const char & other);
 	void append(const LynxString & other);
 	void append(const char * const other, int maxLength = 255);
@@ -0,0 +1,47 @@
+#include "lynxsnapshotqt.h"
+
+bool LynxSnapshotQt::save(const LynxManager & lynx, const QString & fileName)
+{
+    LynxByteArray buffer;
+
+    if (lynx.saveSnapshot(buffer) != LynxLib::eDataCopiedToBuffer)
+        return false;
+
+    // The old snapshot is only replaced once the new one is completely written
+    QSaveFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    if (file.write(buffer.data(), buffer.count()) != buffer.count())
+    {
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
+
+LynxLib::E_LynxState LynxSnapshotQt::load(LynxManager & lynx, const QString & fileName)
+{
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly))
+        return LynxLib::eUnknownError;
+
+    qint64 size = file.size();
+
+    if ((size < 1) || (size > 0x7fffffff))
+        return LynxLib::eWrongDataLength;
+
+    uchar * data = file.map(0, size);
+
+    if (data == nullptr)
+        return LynxLib::eUnknownError;
+
+    LynxLib::E_LynxState state = lynx.loadSnapshot(reinterpret_cast<const char *>(data), int(size));
+
+    file.unmap(data);
+
+    return state;
+}
@@ -0,0 +1,21 @@
+#ifndef LYNXSNAPSHOTQT_H
+#define LYNXSNAPSHOTQT_H
+
+#include "lynxstructure.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QString>
+
+// Saves and restores LynxManager snapshots (see LynxManager::saveSnapshot()) as files
+class LynxSnapshotQt
+{
+public:
+    /// Writes a snapshot of lynx to fileName. Returns false if the file could not be written.
+    static bool save(const LynxManager & lynx, const QString & fileName);
+
+    /// Replaces the contents of lynx with the snapshot in fileName.
+    /// The file is read through a memory map, so it is decoded without being copied first.
+    static LynxLib::E_LynxState load(LynxManager & lynx, const QString & fileName);
+};
+
+#endif // LYNXSNAPSHOTQT_H
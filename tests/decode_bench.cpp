@@ -0,0 +1,109 @@
+// Decoded frames per second on one thread, and heap allocations per decoded frame,
+// for regular and delta frames, before and after freeze().
+
+#include <cstdlib>
+#include <new>
+
+#include "lynxtest.h"
+
+static long allocations = 0;
+
+void * operator new(size_t size)
+{
+	allocations++;
+
+	void * memory = malloc(size == 0 ? 1 : size);
+	if (memory == LYNX_NULL)
+		throw std::bad_alloc();
+
+	return memory;
+}
+
+void * operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void * memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void * memory) noexcept
+{
+	free(memory);
+}
+
+static const int frames = 2000000;
+
+// Returns the allocations per frame
+static double measure(const char * name, LynxManager & lynx, const LynxByteArray & frame)
+{
+	const char * data = frame.data();
+	int size = frame.count();
+	LynxInfo info;
+
+	lynx.fromArray(data, size, info);
+
+	long before = allocations;
+	LynxTimer timer;
+
+	for (int i = 0; i < frames; i++)
+		lynx.fromArray(data, size, info);
+
+	double seconds = timer.seconds();
+	double perFrame = double(allocations - before) / frames;
+
+	printf("%-24s %10.0f frames/s %8.1f ns %8.2f allocations\n", name, frames / seconds, seconds * 1e9 / frames, perFrame);
+
+	if (info.state >= LynxLib::eErrors)
+	{
+		printf("  decoding failed with state %d\n", int(info.state));
+		return -1;
+	}
+
+	return perFrame;
+}
+
+int main()
+{
+	LynxManager sender(1, "Sender");
+	LynxManager lynx(2, "Receiver");
+	LynxManager * managers[] = { &sender, &lynx };
+	LynxId structId;
+
+	for (LynxManager * manager : managers)
+	{
+		structId = manager->addStructure(1, "Values");
+
+		for (int i = 0; i < 8; i++)
+			manager->addVariable(structId, LynxLib::eFloat_RW);
+
+		for (int i = 0; i < 8; i++)
+			manager->addVariable(structId, LynxLib::eInt32_RW);
+	}
+
+	for (int i = 0; i < 16; i++)
+		sender.setValue(i * 1.5, LynxId(0, i));
+
+	LynxByteArray mask;
+	mask.append(char(0x55));
+	mask.append(char(0x55));
+
+	LynxByteArray regular;
+	LynxByteArray delta;
+	LYNX_CHECK(sender.toArray(regular, structId) == LynxLib::eDataCopiedToBuffer);
+	LYNX_CHECK(sender.toArray(delta, structId, mask) == LynxLib::eDataCopiedToBuffer);
+
+	LYNX_CHECK(measure("regular", lynx, regular) == 0);
+	LYNX_CHECK(measure("delta", lynx, delta) == 0);
+
+	lynx.freeze();
+
+	LYNX_CHECK(measure("regular, frozen", lynx, regular) == 0);
+	LYNX_CHECK(measure("delta, frozen", lynx, delta) == 0);
+
+	LYNX_CHECK(lynx.getValue(LynxId(0, 15)) == 22);
+
+	return 0;
+}
@@ -0,0 +1,90 @@
+// Heap allocations and time per encoded frame, for the caller buffer and LynxByteArray paths.
+
+#include <cstdlib>
+#include <new>
+
+#include "lynxtest.h"
+
+static long allocations = 0;
+
+void * operator new(size_t size)
+{
+	allocations++;
+
+	void * memory = malloc(size == 0 ? 1 : size);
+	if (memory == LYNX_NULL)
+		throw std::bad_alloc();
+
+	return memory;
+}
+
+void * operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void * memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void * memory) noexcept
+{
+	free(memory);
+}
+
+static const int frames = 200000;
+
+template <typename Encode>
+static void measure(const char * name, Encode encode)
+{
+	// The first frame may size the caller's buffers
+	encode();
+
+	long before = allocations;
+	LynxTimer timer;
+
+	for (int i = 0; i < frames; i++)
+		encode();
+
+	double time = timer.seconds() * 1e9 / frames;
+
+	printf("%-40s %8.2f allocations %8.1f ns\n", name, double(allocations - before) / frames, time);
+}
+
+int main()
+{
+	LynxManager lynx(1, "Bench");
+	LynxId structId = lynx.addStructure(1, "Values");
+
+	for (int i = 0; i < 8; i++)
+		lynx.addVariable(structId, LynxLib::eFloat_RW);
+
+	for (int i = 0; i < 8; i++)
+		lynx.addVariable(structId, LynxLib::eInt32_RW);
+
+	LynxByteArray mask;
+	mask.append(char(0x55));
+	mask.append(char(0x55));
+
+	char buffer[512];
+	int copiedSize;
+	LynxByteArray byteArray;
+
+	for (int frozen = 0; frozen < 2; frozen++)
+	{
+		if (frozen)
+			lynx.freeze();
+
+		printf("%s\n", frozen ? "frozen" : "not frozen");
+
+		measure("  struct, char buffer", [&] { lynx.toArray(buffer, sizeof(buffer), copiedSize, structId); });
+		measure("  struct, LynxByteArray", [&] { lynx.toArray(byteArray, structId); });
+		measure("  struct, new LynxByteArray per frame", [&] { LynxByteArray fresh; lynx.toArray(fresh, structId); });
+		measure("  variable, char buffer", [&] { lynx.toArray(buffer, sizeof(buffer), copiedSize, LynxId(0, 3)); });
+		measure("  range, char buffer", [&] { lynx.toArray(buffer, sizeof(buffer), copiedSize, LynxId(0, 2), 8); });
+		measure("  delta, char buffer", [&] { lynx.toArray(buffer, sizeof(buffer), copiedSize, structId, mask); });
+	}
+
+	return 0;
+}
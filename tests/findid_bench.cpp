@@ -0,0 +1,53 @@
+// Struct id lookup and frame dispatch time for 1 to 254 structures.
+// Built twice: findid_bench uses the id table, findid_bench_scan is built with LYNX_NO_ID_TABLE.
+
+#include "lynxtest.h"
+
+static const int lookups = 4000000;
+
+int main()
+{
+#ifdef LYNX_NO_ID_TABLE
+	printf("linear search (LYNX_NO_ID_TABLE)\n");
+#else
+	printf("id table\n");
+#endif // LYNX_NO_ID_TABLE
+
+	printf("%8s %14s %14s\n", "structs", "findId ns", "fromArray ns");
+
+	const int sizes[] = { 1, 2, 4, 8, 16, 32, 64, 128, 254 };
+
+	for (int size : sizes)
+	{
+		LynxManager lynx(1, "Bench", size);
+
+		for (int i = 0; i < size; i++)
+		{
+			LynxId structId = lynx.addStructure(char(i + 1), LynxString("Struct") + LynxString::number(i));
+			lynx.addVariable(structId, LynxLib::eFloat_RW);
+		}
+
+		// The last struct is the worst case for a linear search
+		char lastId = char(size);
+		LynxByteArray frame;
+		lynx.toArray(frame, LynxId(size - 1, -1));
+
+		volatile int sink = 0;
+		LynxTimer timer;
+		for (int i = 0; i < lookups; i++)
+			sink = sink + lynx.findId(char(lastId - (i & 1)));
+		double findTime = timer.seconds() * 1e9 / lookups;
+
+		LynxInfo info;
+		timer.restart();
+		for (int i = 0; i < (lookups / 4); i++)
+			lynx.fromArray(frame, info);
+		double dispatchTime = timer.seconds() * 1e9 / (lookups / 4);
+
+		LYNX_CHECK(info.state < LynxLib::eErrors);
+
+		printf("%8d %14.2f %14.2f\n", size, findTime, dispatchTime);
+	}
+
+	return 0;
+}
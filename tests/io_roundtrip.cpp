@@ -0,0 +1,235 @@
+// Frames encoded by one LynxIoDevice and decoded by another through update(): batch frames with and
+// without negotiated batching, range, view and delta frames, half precision and scaled 16 bit values,
+// and batch, range and view frames that are too short or too long for their targets.
+
+#include <cmath>
+#include <deque>
+
+#include "lynxtest.h"
+#include "lynxiodevice.h"
+
+// Everything written to the port arrives at the input of the peer
+class LynxLoopback : public LynxIoDevice
+{
+public:
+	LynxLoopback(LynxManager * lynx) : LynxIoDevice(lynx), peer(LYNX_NULL), writes(0), millis(0) { _open = true; }
+
+	LynxLoopback * peer;
+	std::deque<char> input;
+	int writes;
+	uint32_t millis;
+
+	int read(int count) override
+	{
+		int n = 0;
+
+		for (; (n < count) && !input.empty(); n++)
+		{
+			_readBuffer.append(input.front());
+			input.pop_front();
+		}
+
+		return n;
+	}
+
+	void write() override
+	{
+		writes++;
+
+		for (int i = 0; i < _writeBuffer.count(); i++)
+			peer->input.push_back(_writeBuffer.at(i));
+	}
+
+	int bytesAvailable() const override { return int(input.size()); }
+	uint32_t getMillis() const override { return millis; }
+
+	// Reads everything waiting at the input, and returns the last frame that was decoded
+	LynxInfo receive()
+	{
+		LynxInfo last;
+
+		while (!input.empty())
+		{
+			const LynxInfo & info = this->update();
+
+			if (info.state != LynxLib::eNoChange)
+				last = info;
+		}
+
+		return last;
+	}
+
+	// Queues frame with its data length at lengthIndex changed by change bytes, with a new checksum
+	void receiveResized(const LynxByteArray & frame, int lengthIndex, int change)
+	{
+		LynxByteArray resized;
+
+		for (int i = 0; i < (frame.count() - LYNX_CHECKSUM_BYTES + (change < 0 ? change : 0)); i++)
+			resized.append(frame.at(i));
+
+		for (int i = 0; i < change; i++)
+			resized.append(char(0));
+
+		int length = ((int(frame.at(lengthIndex)) & 0xff) | ((int(frame.at(lengthIndex + 1)) & 0xff) << 8)) + change;
+		resized[lengthIndex] = char(length & 0xff);
+		resized[lengthIndex + 1] = char((length >> 8) & 0xff);
+
+		LynxLib::addChecksum(resized);
+
+		for (int i = 0; i < resized.count(); i++)
+			input.push_back(resized.at(i));
+	}
+};
+
+static void addStructures(LynxManager & lynx)
+{
+	for (int s = 0; s < 4; s++)
+	{
+		LynxId structId = lynx.addStructure(char(10 + s), LynxString("Struct") + LynxString::number(s));
+
+		lynx.addVariable(structId, LynxLib::eInt16_RW, "Int");
+		lynx.addVariable(structId, LynxLib::eFloat_RW, "Float");
+		lynx.addVariable(structId, LynxLib::eHalf_RW, "Half");
+		lynx.addVariable(structId, LynxLib::eScaled16_RW, "Scaled");
+		lynx.setScaling(LynxId(s, 3), 0.01f, 20.0f);
+	}
+}
+
+int main()
+{
+	LynxManager a(1, "A");
+	LynxManager b(2, "B");
+	addStructures(a);
+	addStructures(b);
+
+	LynxLoopback deviceA(&a);
+	LynxLoopback deviceB(&b);
+	deviceA.peer = &deviceB;
+	deviceB.peer = &deviceA;
+
+	LynxInfo info;
+
+	// Half precision and scaled 16 bit values keep their wire precision
+	a.setValue(-1234, LynxId(0, 0));
+	a.setValue(3.75, LynxId(0, 1));
+	a.setValue(3.14159, LynxId(0, 2));
+	a.setValue(25.456, LynxId(0, 3));
+	LYNX_CHECK(deviceA.send(LynxId(0, -1)) == LynxLib::eDataCopiedToBuffer);
+	info = deviceB.receive();
+	LYNX_CHECK(info.state == LynxLib::eNewDataReceived);
+	LYNX_CHECK(b.getValue(LynxId(0, 0)) == -1234);
+	LYNX_CHECK(b.getValue(LynxId(0, 1)) == 3.75);
+	LYNX_CHECK(std::fabs(b.getValue(LynxId(0, 2)) - 3.14159) < 0.002);
+	LYNX_CHECK(std::fabs(b.getValue(LynxId(0, 3)) - 25.456) <= 0.005 + 1e-6);
+
+	// Without negotiated batching every periodic target is a frame of its own
+	for (int s = 0; s < 4; s++)
+	{
+		a.setValue(s * 10, LynxId(s, 0));
+		deviceA.periodicStart(LynxId(s, -1), 10);
+	}
+
+	deviceA.writes = 0;
+	deviceA.millis = 10;
+	deviceA.periodicUpdate();
+	LYNX_CHECK(deviceA.writes == 4);
+	info = deviceB.receive();
+	LYNX_CHECK(info.state == LynxLib::eNewDataReceived);
+
+	for (int s = 0; s < 4; s++)
+		LYNX_CHECK(b.getValue(LynxId(s, 0)) == s * 10);
+
+	// The receiver decodes a batch frame sent directly, before anything is negotiated
+	LynxList<LynxId> batch;
+	batch.append(LynxId(0, -1));
+	batch.append(LynxId(1, 0));
+	a.setValue(11, LynxId(0, 0));
+	a.setValue(12, LynxId(1, 0));
+	LYNX_CHECK(deviceA.send(batch) == LynxLib::eDataCopiedToBuffer);
+	LYNX_CHECK(deviceB.receive().state == LynxLib::eNewDataReceived);
+	LYNX_CHECK(deviceB.batchContents().count() == 2);
+	LYNX_CHECK(b.getValue(LynxId(0, 0)) == 11 && b.getValue(LynxId(1, 0)) == 12);
+
+	// Once the receiver has told it can take batches, they are sent as one batch frame
+	deviceA.negotiateCapabilities();
+	LYNX_CHECK(deviceB.receive().state == LynxLib::eCapabilitiesReceived);
+	LYNX_CHECK(deviceA.receive().state == LynxLib::eCapabilitiesReceived);
+	LYNX_CHECK(deviceA.remoteCapabilities() == LynxLib::eCapabilityBatch);
+
+	for (int s = 0; s < 4; s++)
+		a.setValue(s * 100, LynxId(s, 0));
+
+	deviceA.writes = 0;
+	deviceA.millis = 20;
+	deviceA.periodicUpdate();
+	LYNX_CHECK(deviceA.writes == 1);
+	info = deviceB.receive();
+	LYNX_CHECK(info.state == LynxLib::eNewDataReceived);
+	LYNX_CHECK(deviceB.batchContents().count() == 4);
+
+	for (int s = 0; s < 4; s++)
+		LYNX_CHECK(b.getValue(LynxId(s, 0)) == s * 100);
+
+	for (int s = 0; s < 4; s++)
+		deviceA.periodicStop(LynxId(s, -1));
+
+	// Range
+	a.setValue(7.5, LynxId(1, 1));
+	a.setValue(1.5, LynxId(1, 2));
+	LYNX_CHECK(deviceA.send(LynxId(1, 1), 2) == LynxLib::eDataCopiedToBuffer);
+	LYNX_CHECK(deviceB.receive().state == LynxLib::eNewDataReceived);
+	LYNX_CHECK(b.getValue(LynxId(1, 1)) == 7.5 && b.getValue(LynxId(1, 2)) == 1.5);
+
+	// View, defined on the receiver by the sender
+	LynxList<LynxId> targets;
+	targets.append(LynxId(2, -1));
+	targets.append(LynxId(3, 1));
+	LynxViewId view = a.addView(5, targets, "View");
+	deviceA.defineRemoteView(view);
+	LYNX_CHECK(deviceB.receive().state == LynxLib::eViewDefined);
+
+	a.setValue(-5, LynxId(2, 0));
+	a.setValue(0.125, LynxId(3, 1));
+	LYNX_CHECK(deviceA.send(view) == LynxLib::eDataCopiedToBuffer);
+	LYNX_CHECK(deviceB.receive().state == LynxLib::eNewDataReceived);
+	LYNX_CHECK(b.getValue(LynxId(2, 0)) == -5 && b.getValue(LynxId(3, 1)) == 0.125);
+
+	// Delta, only the changed variable is sent
+	uint32_t stamp = 0;
+	LYNX_CHECK(deviceA.sendChanged(LynxId(3, -1), stamp) == LynxLib::eDataCopiedToBuffer);
+	deviceB.receive();
+	a.setValue(42, LynxId(3, 0));
+	b.setValue(0, LynxId(3, 1));
+	LYNX_CHECK(deviceA.sendChanged(LynxId(3, -1), stamp) == LynxLib::eDataCopiedToBuffer);
+	LYNX_CHECK(deviceB.receive().state == LynxLib::eNewDataReceived);
+	LYNX_CHECK(b.getValue(LynxId(3, 0)) == 42 && b.getValue(LynxId(3, 1)) == 0);
+	LYNX_CHECK(deviceA.sendChanged(LynxId(3, -1), stamp) == LynxLib::eNoChange);
+
+	// Frames with one byte too few or too many for their targets are refused
+	LynxByteArray frames[3];
+	LYNX_CHECK(a.toArray(frames[0], batch) == LynxLib::eDataCopiedToBuffer);
+	LYNX_CHECK(a.toArray(frames[1], LynxId(1, 1), 2) == LynxLib::eDataCopiedToBuffer);
+	LYNX_CHECK(a.toArray(frames[2], view) == LynxLib::eDataCopiedToBuffer);
+	const int lengthIndexes[3] = { 3, 6, 4 };
+
+	for (int f = 0; f < 3; f++)
+	{
+		for (int change = -1; change <= 1; change += 2)
+		{
+			deviceB.receiveResized(frames[f], lengthIndexes[f], change);
+			info = deviceB.receive();
+
+			printf("frame %d, %+d bytes: state %d\n", f, change, int(info.state));
+			LYNX_CHECK(info.state >= LynxLib::eErrors);
+		}
+	}
+
+	// The frames themselves still decode
+	for (int f = 0; f < 3; f++)
+	{
+		deviceB.receiveResized(frames[f], lengthIndexes[f], 0);
+		LYNX_CHECK(deviceB.receive().state == LynxLib::eNewDataReceived);
+	}
+
+	return 0;
+}
@@ -0,0 +1,33 @@
+#ifndef LYNX_TEST_H
+#define LYNX_TEST_H
+
+#include <chrono>
+#include <cstdio>
+
+#include "LynxStructure.h"
+
+// Returns 1 from the calling function when the condition is false
+#define LYNX_CHECK(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+			return 1; \
+		} \
+	} while (0)
+
+class LynxTimer
+{
+public:
+	LynxTimer() : _start(std::chrono::steady_clock::now()) {}
+
+	void restart() { _start = std::chrono::steady_clock::now(); }
+
+	double seconds() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count(); }
+
+private:
+	std::chrono::steady_clock::time_point _start;
+};
+
+#endif // LYNX_TEST_H
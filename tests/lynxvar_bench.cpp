@@ -0,0 +1,48 @@
+// Read and write throughput of a float through LynxVar_float, LynxManager::getValue()/setValue()
+// and LynxManager::variable().
+
+#include "lynxtest.h"
+
+static const int operations = 20000000;
+
+template <typename Work>
+static void measure(const char * name, Work work)
+{
+	// Warm up, and look up the pointer of the handles
+	work(0);
+
+	LynxTimer timer;
+
+	for (int i = 0; i < operations; i++)
+		work(i);
+
+	double seconds = timer.seconds();
+
+	printf("%-32s %10.2f Mops/s %8.2f ns\n", name, operations / seconds / 1e6, seconds * 1e9 / operations);
+}
+
+int main()
+{
+	LynxManager lynx(1, "Bench");
+	LynxId structId = lynx.addStructure(1, "Values");
+
+	// Some variables in front, so the handle isn't the first value of the block
+	for (int i = 0; i < 8; i++)
+		lynx.addVariable(structId, LynxLib::eInt32_RW);
+
+	LynxVar_float handle(lynx, structId, "Value");
+	LynxId lynxId = handle.lynxId();
+
+	volatile float sink = 0;
+
+	measure("LynxVar_float read", [&](int) { sink = sink + handle; });
+	measure("LynxVar_float write", [&](int i) { handle = float(i); });
+	measure("getValue", [&](int) { sink = sink + float(lynx.getValue(lynxId)); });
+	measure("setValue", [&](int i) { lynx.setValue(float(i), lynxId); });
+	measure("variable().var_float() read", [&](int) { sink = sink + lynx.variable(lynxId).var_float(); });
+	measure("variable().var_float() write", [&](int i) { lynx.variable(lynxId).var_float() = float(i); });
+
+	LYNX_CHECK(float(handle) == float(operations - 1));
+
+	return 0;
+}
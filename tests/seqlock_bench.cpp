@@ -0,0 +1,90 @@
+// Throughput of decoding and snapshots with and without the seqlock,
+// alone and with a writer and a reader running at the same time.
+
+#include <atomic>
+#include <thread>
+
+#include "lynxtest.h"
+
+static const int variableCount = 16;
+static const double runTime = 0.5;
+
+static void run(LynxManager & lynx, const LynxId & structId, const LynxByteArray & frame, const char * name)
+{
+	LynxInfo info;
+	LynxList<LynxUnion> values;
+
+	// Alone
+	long writes = 0;
+	LynxTimer timer;
+	while (timer.seconds() < runTime)
+	{
+		for (int i = 0; i < 1000; i++)
+			lynx.fromArray(frame, info);
+
+		writes += 1000;
+	}
+	double writeRate = writes / timer.seconds();
+
+	long reads = 0;
+	timer.restart();
+	while (timer.seconds() < runTime)
+	{
+		for (int i = 0; i < 1000; i++)
+			lynx.snapshot(structId, values);
+
+		reads += 1000;
+	}
+	double readRate = reads / timer.seconds();
+
+	// Together
+	std::atomic<bool> stop(false);
+	std::atomic<long> sharedWrites(0);
+	std::thread writer([&]
+	{
+		LynxInfo writerInfo;
+		long count = 0;
+		while (!stop.load(std::memory_order_relaxed))
+		{
+			lynx.fromArray(frame, writerInfo);
+			count++;
+		}
+		sharedWrites = count;
+	});
+
+	reads = 0;
+	long retries = 0;
+	timer.restart();
+	while (timer.seconds() < runTime)
+	{
+		for (int i = 0; i < 1000; i++)
+			retries += lynx.snapshot(structId, values);
+
+		reads += 1000;
+	}
+	double seconds = timer.seconds();
+	stop = true;
+	writer.join();
+
+	printf("%-12s alone: %6.2f M decodes/s %6.2f M snapshots/s   together: %6.2f M decodes/s %6.2f M snapshots/s %.2f retries per snapshot\n",
+		name, writeRate / 1e6, readRate / 1e6, sharedWrites / seconds / 1e6, reads / seconds / 1e6, double(retries) / reads);
+}
+
+int main()
+{
+	LynxManager lynx(1, "Bench");
+	LynxId structId = lynx.addStructure(1, "Values");
+
+	for (int i = 0; i < variableCount; i++)
+		lynx.addVariable(structId, LynxLib::eInt64_RW);
+
+	LynxByteArray frame;
+	lynx.toArray(frame, structId);
+
+	run(lynx, structId, frame, "unprotected");
+
+	lynx.setConcurrencyMode(structId, LynxLib::eSeqlock);
+	run(lynx, structId, frame, "seqlock");
+
+	return 0;
+}
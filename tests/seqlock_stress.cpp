@@ -0,0 +1,106 @@
+// Two threads: one writes every variable of a seqlock struct with the same value,
+// the other takes snapshots and checks that it never sees a mix of two writes.
+// Single bit writes through LynxVar::setBit() must make the readers retry as well.
+
+#include <atomic>
+#include <thread>
+
+#include "lynxtest.h"
+
+static const int variableCount = 16;
+
+// Returns the number of torn snapshots seen while writer runs for the given time
+template <typename Writer>
+static long stress(LynxManager & lynx, const LynxId & structId, Writer writer, double seconds, long & retries)
+{
+	std::atomic<bool> stop(false);
+	std::thread thread([&] { for (int64_t n = 1; !stop.load(std::memory_order_relaxed); n++) writer(n); });
+
+	LynxList<LynxUnion> values;
+	long torn = 0;
+	retries = 0;
+
+	LynxTimer timer;
+	while (timer.seconds() < seconds)
+	{
+		retries += lynx.snapshot(structId, values);
+
+		for (int i = 1; i < variableCount; i++)
+		{
+			if (values.at(i)._var_i64 != values.at(0)._var_i64)
+			{
+				torn++;
+				break;
+			}
+		}
+	}
+
+	stop = true;
+	thread.join();
+
+	return torn;
+}
+
+int main()
+{
+	LynxManager sender(1, "Sender");
+	LynxId sendStruct = sender.addStructure(1, "Values");
+
+	LynxManager lynx(2, "Receiver");
+	LynxId structId = lynx.addStructure(1, "Values");
+	LynxVar_i64 first(lynx, structId, "First");
+
+	for (int i = 0; i < variableCount; i++)
+		sender.addVariable(sendStruct, LynxLib::eInt64_RW);
+
+	for (int i = 1; i < variableCount; i++)
+		lynx.addVariable(structId, LynxLib::eInt64_RW);
+
+	lynx.setConcurrencyMode(structId, LynxLib::eSeqlock);
+
+	LynxByteArray frames[4];
+	for (int k = 0; k < 4; k++)
+	{
+		for (int i = 0; i < variableCount; i++)
+			sender.setValue(double(k * 1000003), LynxId(0, i));
+
+		LYNX_CHECK(sender.toArray(frames[k], sendStruct) == LynxLib::eDataCopiedToBuffer);
+	}
+
+	long retries;
+
+	// Received frames
+	long torn = stress(lynx, structId, [&](int64_t n)
+	{
+		LynxInfo info;
+		lynx.fromArray(frames[n % 4], info);
+	}, 0.5, retries);
+
+	printf("decoded frames: %ld torn, %ld retries\n", torn, retries);
+	LYNX_CHECK(torn == 0);
+
+	// Application writes through LynxVar and setValue(), grouped into one write
+	torn = stress(lynx, structId, [&](int64_t n)
+	{
+		lynx.beginWrite(structId);
+		first = n;
+		for (int i = 1; i < variableCount; i++)
+			lynx.setValue(double(n), LynxId(0, i));
+		lynx.endWrite(structId);
+	}, 0.5, retries);
+
+	printf("application writes: %ld torn, %ld retries\n", torn, retries);
+	LYNX_CHECK(torn == 0);
+	LYNX_CHECK(retries > 0);
+
+	// Single bits through LynxVar::setBit(), which brackets the store by itself, so the readers retry
+	stress(lynx, structId, [&](int64_t n)
+	{
+		first.setBit(int(n % 64), (n & 64) != 0);
+	}, 0.5, retries);
+
+	printf("bit writes: %ld retries\n", retries);
+	LYNX_CHECK(retries > 0);
+
+	return 0;
+}
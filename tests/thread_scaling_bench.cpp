@@ -0,0 +1,106 @@
+// Throughput of 1 to 16 threads in thread safe mode, each working on its own structure
+// or all of them on the same one. Every operation is a setValue() and a getValue(),
+// or a toArray() and fromArray() of the whole structure.
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "lynxtest.h"
+
+static const int maxThreads = 16;
+static const int variableCount = 8;
+static const int iterations = 100000;
+
+template <typename Work>
+static double run(int threadCount, Work work)
+{
+	std::atomic<int> ready(0);
+	std::atomic<bool> start(false);
+	std::vector<std::thread> threads;
+
+	for (int t = 0; t < threadCount; t++)
+	{
+		threads.emplace_back([&, t]
+		{
+			ready++;
+			while (!start.load())
+			{
+			}
+
+			work(t);
+		});
+	}
+
+	// All the threads start together, once they are running
+	while (ready.load() < threadCount)
+	{
+	}
+
+	LynxTimer timer;
+	start = true;
+
+	for (size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+
+	return double(threadCount) * iterations / timer.seconds();
+}
+
+int main()
+{
+	LynxManager lynx(1, "Bench");
+	lynx.setThreadSafe(true);
+
+	LynxId structs[maxThreads];
+
+	for (int i = 0; i < maxThreads; i++)
+	{
+		structs[i] = lynx.addStructure(char(i + 1), LynxString("Struct") + LynxString::number(i));
+
+		for (int j = 0; j < variableCount; j++)
+			lynx.addVariable(structs[i], LynxLib::eInt32_RW);
+	}
+
+	printf("%8s %22s %22s %22s\n", "threads", "values own (Mops/s)", "values shared (Mops/s)", "frames own (Mops/s)");
+
+	for (int threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+	{
+		double own = run(threadCount, [&](int t)
+		{
+			volatile double sink = 0;
+
+			for (int i = 0; i < iterations; i++)
+			{
+				lynx.setValue(i, LynxId(structs[t].structIndex, i % variableCount));
+				sink = sink + lynx.getValue(LynxId(structs[t].structIndex, (i + 1) % variableCount));
+			}
+		});
+
+		double shared = run(threadCount, [&](int)
+		{
+			volatile double sink = 0;
+
+			for (int i = 0; i < iterations; i++)
+			{
+				lynx.setValue(i, LynxId(structs[0].structIndex, i % variableCount));
+				sink = sink + lynx.getValue(LynxId(structs[0].structIndex, (i + 1) % variableCount));
+			}
+		});
+
+		double frames = run(threadCount, [&](int t)
+		{
+			LynxByteArray buffer;
+			LynxInfo info;
+
+			for (int i = 0; i < iterations; i++)
+			{
+				lynx.toArray(buffer, structs[t]);
+				lynx.fromArray(buffer, info);
+			}
+		});
+
+		printf("%8d %22.2f %22.2f %22.2f\n", threadCount, own / 1e6, shared / 1e6, frames / 1e6);
+	}
+
+	return 0;
+}
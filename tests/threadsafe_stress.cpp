@@ -0,0 +1,129 @@
+// Thread safe mode under contention: copies between two structures in both directions,
+// strings changing size, and views and batches encoded and decoded while structures, variables, views
+// and their names are added and looked up.
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "lynxtest.h"
+
+static const int structCount = 8;
+static const int iterations = 20000;
+
+int main()
+{
+	LynxManager lynx(1, "Stress");
+	lynx.setThreadSafe(true);
+
+	LynxId structs[structCount];
+
+	for (int i = 0; i < structCount; i++)
+	{
+		structs[i] = lynx.addStructure(char(i + 1), LynxString("Struct") + LynxString::number(i));
+
+		for (int j = 0; j < 4; j++)
+			lynx.addVariable(structs[i], LynxLib::eInt32_RW);
+
+		lynx.addVariable(structs[i], LynxLib::eString_RW);
+	}
+
+	LynxList<LynxId> ids;
+	ids.append(structs[0]);
+	ids.append(structs[1]);
+
+	LynxViewId view = lynx.addView(1, ids, "View");
+	LYNX_CHECK(view.viewIndex >= 0);
+
+	std::atomic<int> failures(0);
+	std::vector<std::thread> threads;
+
+	threads.emplace_back([&] { for (int i = 0; i < iterations; i++) lynx.copy(LynxId(0, 0), LynxId(1, 0), 2); });
+	threads.emplace_back([&] { for (int i = 0; i < iterations; i++) lynx.copy(LynxId(1, 2), LynxId(0, 2), 2); });
+	threads.emplace_back([&] { for (int i = 0; i < iterations; i++) lynx.setString((i & 1) ? "Short" : "A much longer string value", LynxId(0, 4)); });
+
+	threads.emplace_back([&]
+	{
+		LynxByteArray buffer;
+		LynxInfo info;
+
+		for (int i = 0; i < iterations; i++)
+		{
+			if (lynx.toArray(buffer, view) != LynxLib::eDataCopiedToBuffer)
+				failures++;
+
+			lynx.fromArray(buffer, info);
+
+			if (info.state >= LynxLib::eErrors)
+				failures++;
+		}
+	});
+
+	threads.emplace_back([&]
+	{
+		LynxByteArray buffer;
+		LynxInfo info;
+
+		for (int i = 0; i < iterations; i++)
+		{
+			if (lynx.toArray(buffer, ids) != LynxLib::eDataCopiedToBuffer)
+				failures++;
+
+			lynx.fromArray(buffer, info);
+
+			if (info.state >= LynxLib::eErrors)
+				failures++;
+		}
+	});
+
+	// Structures, variables and views added while the others are in use
+	threads.emplace_back([&]
+	{
+		for (int i = 0; i < 100; i++)
+		{
+			LynxStructInfo structInfo;
+			structInfo.structId = char(structCount + 1 + i);
+			structInfo.description = LynxString("Added") + LynxString::number(i);
+			structInfo.variableCount = 1;
+			structInfo.variables.append(LynxVariableInfo());
+			structInfo.variables.last().dataType = LynxLib::eFloat_RW;
+
+			if (lynx.addStructure(structInfo).structLynxId.structIndex < 0)
+				failures++;
+
+			if (lynx.addVariable(structs[2 + (i % 2)], LynxLib::eInt32_RW, LynxString("Extra") + LynxString::number(i)).variableIndex < 0)
+				failures++;
+
+			if (lynx.addView(char(2 + (i % 4)), ids, LynxString("View") + LynxString::number(i % 4)).viewIndex < 0)
+				failures++;
+		}
+	});
+
+	// Name lookups while the names are added
+	threads.emplace_back([&]
+	{
+		for (int i = 0; i < iterations; i++)
+		{
+			if (lynx.findStructure("Struct3").structIndex != structs[3].structIndex)
+				failures++;
+
+			if (lynx.findVariable("Extra0").variableIndex == 0)
+				failures++;
+
+			lynx.findStructure(LynxString("Added") + LynxString::number(i % 100));
+			lynx.findView(LynxString("View") + LynxString::number(i % 4));
+		}
+	});
+
+	for (size_t i = 0; i < threads.size(); i++)
+		threads[i].join();
+
+	printf("%d failures, %d structures\n", int(failures), lynx.count());
+
+	LYNX_CHECK(failures == 0);
+	LYNX_CHECK(lynx.count() == structCount + 100);
+	LYNX_CHECK(lynx.findVariable("Extra99").structIndex == structs[3].structIndex);
+	LYNX_CHECK(lynx.viewCount() == 5);
+
+	return 0;
+}